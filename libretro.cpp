@@ -1,6 +1,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <stdlib.h>
 
 #include "mednafen/mednafen.h"
 #include "mednafen/mempatcher.h"
@@ -38,8 +39,26 @@ static double last_sound_rate;
 static MDFN_PixelFormat last_pixel_format;
 
 static MDFN_Surface *surf;
+static MDFN_Surface fb_surf;
+
+/* Frameskip: 0 off, 1 when the frontend expects an audio underrun, 2 when
+ * its audio buffer is less than frameskip_threshold percent full.  At
+ * most FRAMESKIP_MAX frames in a row are skipped. */
+#define FRAMESKIP_MAX 30
+
+static unsigned frameskip_type;
+static unsigned frameskip_threshold = 33;
+static unsigned frameskip_counter;
+
+static bool retro_audio_buff_active;
+static unsigned retro_audio_buff_occupancy;
+static bool retro_audio_buff_underrun;
+
+static unsigned audio_latency;
+static bool update_audio_latency;
 
 static bool failed_init;
+static bool can_dupe;
 
 static void hookup_ports(bool force);
 
@@ -197,6 +216,9 @@ void retro_init(void)
    else
       perf_get_cpu_features_cb = NULL;
 
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &can_dupe))
+      can_dupe = false;
+
    retro_rumble_interface rumble;
    if (environ_cb(RETRO_ENVIRONMENT_GET_RUMBLE_INTERFACE, &rumble))
       rumble_cb = rumble.set_rumble_state;
@@ -216,6 +238,49 @@ bool retro_load_game_special(unsigned, const struct retro_game_info *, size_t)
    return false;
 }
 
+static void retro_audio_buff_status_cb(bool active, unsigned occupancy, bool underrun_likely)
+{
+   retro_audio_buff_active    = active;
+   retro_audio_buff_occupancy = occupancy;
+   retro_audio_buff_underrun  = underrun_likely;
+}
+
+static void init_frameskip(void)
+{
+   if (frameskip_type > 0)
+   {
+      struct retro_audio_buffer_status_callback buf_status_cb;
+
+      buf_status_cb.callback = retro_audio_buff_status_cb;
+      if (!environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &buf_status_cb))
+      {
+         if (log_cb)
+            log_cb(RETRO_LOG_WARN, "Frameskip disabled - frontend does not support audio buffer status monitoring.\n");
+
+         retro_audio_buff_active    = false;
+         retro_audio_buff_occupancy = 0;
+         retro_audio_buff_underrun  = false;
+         audio_latency              = 0;
+      }
+      else
+      {
+         /* Six frames of latency, rounded up to a multiple of 32 ms,
+          * leave room for the skipped frames to catch up. */
+         float frame_time_msec = 1000.0f / MEDNAFEN_CORE_TIMING_FPS;
+
+         audio_latency = (unsigned)((6.0f * frame_time_msec) + 0.5f);
+         audio_latency = (audio_latency + 0x1F) & ~0x1F;
+      }
+   }
+   else
+   {
+      environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, NULL);
+      audio_latency = 0;
+   }
+
+   update_audio_latency = true;
+}
+
 static void check_variables(bool startup)
 {
    struct retro_variable var = {0};
@@ -230,6 +295,62 @@ static void check_variables(bool startup)
          setting_gba_hle = 0;
    }
 
+   var.key = "gba_idle_loop";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         setting_gba_idle_loop = 1;
+      else if (strcmp(var.value, "disabled") == 0)
+         setting_gba_idle_loop = 0;
+   }
+
+   var.key = "gba_mp2k_hle";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         setting_gba_mp2k_hle = 1;
+      else if (strcmp(var.value, "high_quality") == 0)
+         setting_gba_mp2k_hle = 2;
+      else if (strcmp(var.value, "disabled") == 0)
+         setting_gba_mp2k_hle = 0;
+   }
+
+#ifdef HAVE_RENDER_THREAD
+   var.key = "gba_threaded_render";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         setting_gba_threaded_render = 1;
+      else if (strcmp(var.value, "disabled") == 0)
+         setting_gba_threaded_render = 0;
+   }
+#endif
+
+   unsigned old_frameskip_type = frameskip_type;
+
+   var.key = "gba_frameskip";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "auto") == 0)
+         frameskip_type = 1;
+      else if (strcmp(var.value, "auto_threshold") == 0)
+         frameskip_type = 2;
+      else
+         frameskip_type = 0;
+   }
+
+   var.key = "gba_frameskip_threshold";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      frameskip_threshold = strtol(var.value, NULL, 10);
+
+   if (!startup && frameskip_type != old_frameskip_type)
+      init_frameskip();
+
    var.key = "gba_use_mednafen_save_method";
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && startup)
@@ -293,6 +414,7 @@ bool retro_load_game(const struct retro_game_info *info)
    set_basename(info->path);
 
    check_variables(true);
+   init_frameskip();
 
    game = MDFNI_LoadGame(MEDNAFEN_CORE_NAME_MODULE, (const uint8_t *)info->data, info->size);
    if (!game)
@@ -462,6 +584,47 @@ static void update_input(void)
    }
 }
 
+/* Points fb_surf at the frontend's framebuffer for this frame, when it
+ * has the pixel format the core renders.  Its contents are unspecified, so
+ * it is only used when the whole frame is drawn this run or none of it is:
+ * a frame with no line drawn is duped, and the skipped lines of one with
+ * some drawn are drawn as well. */
+static bool get_frontend_framebuffer(struct retro_framebuffer *fb)
+{
+   if (!can_dupe || FrameUnderway())
+      return false;
+
+   memset(fb, 0, sizeof(*fb));
+   fb->width        = FB_WIDTH;
+   fb->height       = FB_HEIGHT;
+   fb->access_flags = RETRO_MEMORY_ACCESS_WRITE;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, fb) || !fb->data)
+      return false;
+
+#if defined(WANT_32BPP)
+   if (fb->format != RETRO_PIXEL_FORMAT_XRGB8888 || (fb->pitch & 3) || fb->pitch < (FB_WIDTH << 2))
+      return false;
+   fb_surf.pixels = (uint32 *)fb->data;
+   fb_surf.pitch32 = fb->pitch >> 2;
+#elif defined(WANT_16BPP)
+#ifdef FRONTEND_SUPPORTS_RGB565
+   if (fb->format != RETRO_PIXEL_FORMAT_RGB565)
+#else
+   if (fb->format != RETRO_PIXEL_FORMAT_0RGB1555)
+#endif
+      return false;
+   if ((fb->pitch & 1) || fb->pitch < (FB_WIDTH << 1))
+      return false;
+   fb_surf.pixels16 = (uint16 *)fb->data;
+   fb_surf.pitchinpix = fb->pitch >> 1;
+#endif
+   fb_surf.w      = FB_WIDTH;
+   fb_surf.h      = FB_HEIGHT;
+   fb_surf.format = surf->format;
+   return true;
+}
+
 void retro_run()
 {
    input_poll_cb();
@@ -472,8 +635,35 @@ void retro_run()
    static MDFN_Rect rects[FB_MAX_HEIGHT];
    rects[0].w = ~0;
 
+   bool skip = false;
+
+   if (frameskip_type && retro_audio_buff_active)
+   {
+      if (frameskip_type == 1)
+         skip = retro_audio_buff_underrun;
+      else
+         skip = retro_audio_buff_occupancy < frameskip_threshold;
+
+      if (!skip || frameskip_counter >= FRAMESKIP_MAX)
+      {
+         skip = false;
+         frameskip_counter = 0;
+      }
+      else
+         frameskip_counter++;
+   }
+
+   if (update_audio_latency)
+   {
+      environ_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &audio_latency);
+      update_audio_latency = false;
+   }
+
+   struct retro_framebuffer fb;
+   bool use_fb = !skip && get_frontend_framebuffer(&fb);
+
    EmulateSpecStruct spec = {0};
-   spec.surface = surf;
+   spec.surface = use_fb ? &fb_surf : surf;
    spec.SoundRate = 44100;
    spec.SoundBuf = sound_buf;
    spec.LineWidths = rects;
@@ -483,6 +673,7 @@ void retro_run()
    spec.SoundBufSize = 0;
    spec.VideoFormatChanged = false;
    spec.SoundFormatChanged = false;
+   spec.skip = skip;
 
    if (memcmp(&last_pixel_format, &spec.surface->format, sizeof(MDFN_PixelFormat)))
    {
@@ -502,13 +693,24 @@ void retro_run()
    unsigned width  = spec.DisplayRect.w;
    unsigned height = spec.DisplayRect.h;
 
+   if ((skip || spec.FrameUnchanged) && can_dupe)
+      video_cb(NULL, width, height, 0);
+   else if (use_fb)
+      video_cb(fb.data, width, height, fb.pitch);
+   else
+   {
 #if defined(WANT_32BPP)
-   const uint32_t *pix = surf->pixels;
-   video_cb(pix, width, height, FB_WIDTH << 2);
+      const uint32_t *pix = surf->pixels;
+      video_cb(pix, width, height, FB_WIDTH << 2);
 #elif defined(WANT_16BPP)
-   const uint16_t *pix = surf->pixels16;
-   video_cb(pix, width, height, FB_WIDTH << 1);
+      const uint16_t *pix = surf->pixels16;
+      video_cb(pix, width, height, FB_WIDTH << 1);
 #endif
+   }
+
+   /* the frontend's buffer is not ours to keep, nor to free */
+   fb_surf.pixels   = NULL;
+   fb_surf.pixels16 = NULL;
 
    audio_batch_cb(spec.SoundBuf, spec.SoundBufSize);
 
@@ -570,6 +772,13 @@ void retro_set_environment(retro_environment_t cb)
    static const struct retro_variable vars[] = {
       { "gba_hle", "HLE bios emulation (Restart); enabled|disabled" },
       { "gba_use_mednafen_save_method", "Save method (Restart); mednafen|libretro" },
+      { "gba_idle_loop", "Idle loop skipping; enabled|disabled" },
+      { "gba_mp2k_hle", "MP2K sound driver HLE; disabled|enabled|high_quality" },
+#ifdef HAVE_RENDER_THREAD
+      { "gba_threaded_render", "Threaded rendering; disabled|enabled" },
+#endif
+      { "gba_frameskip", "Frameskip; disabled|auto|auto_threshold" },
+      { "gba_frameskip_threshold", "Frameskip threshold (%); 33|15|18|21|24|27|30|36|39|42|45|48|51|54|57|60" },
       { NULL, NULL },
    };
    cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void*)vars);
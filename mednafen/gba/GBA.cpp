@@ -34,6 +34,14 @@
 
 #include "mednafen/gba/arm.h"
 #include "mednafen/gba/thumb.h"
+#include "mednafen/gba/event.h"
+#include "mednafen/gba/mp2k.h"
+#ifdef HAVE_RENDER_THREAD
+#include <pthread.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef WANT_CRC32
 #include "scrc32.h"
@@ -41,6 +49,7 @@
 
 static bool CPUInit(const std::string bios_fn) MDFN_COLD;
 static void CPUReset(void) MDFN_COLD;
+static void CPUUpdateVRAMPages(void);
 static void CPUUpdateRender(void);
 
 #define UPDATE_REG(address, value)\
@@ -55,7 +64,6 @@ static void CPUUpdateRender(void);
 RTC *GBA_RTC = NULL;
 
 int SWITicks = 0;
-int IRQTicks = 0;
 
 int layerEnableDelay = 0;
 bool busPrefetch = false;
@@ -70,10 +78,22 @@ int dummyAddress = 0;
 bool cpuBreakLoop = false;
 int cpuNextEvent = 0;
 
+// Idle loop skipping.  cpuIdleLoopActivity is bumped by every memory write
+// and by reads whose result depends on time or that change device state.
+bool cpuIdleLoopSkip = false;
+uint32 cpuIdleLoopActivity = 0;
+static uint32 idleLoopOverride;
+static uint32 idleLoopPC;
+static uint32 idleLoopSeen;
+static uint32 idleLoopState[21];
+static bool idleLoopStateValid;
+
 static bool intState = false;
 static bool stopState = false;
 static bool holdState = false;
 static int holdType = 0;
+uint64 cpuHaltTicks = 0;
+uint64 cpuHaltOverflows = 0;
 
 static bool FlashSizeSet; // Set to true if explicitly set by the user
 bool cpuSramEnabled;
@@ -84,17 +104,204 @@ bool cpuEEPROMSensorEnabled;
 uint32 cpuPrefetch[2];
 
 int cpuTotalTicks = 0;
-static int lcdTicks;
 uint8 timerOnOffDelay = 0;
 
 GBATimer timers[4];
 
 uint32 dmaSource[4] = {0};
 uint32 dmaDest[4] = {0};
-void (*renderLine)() = mode0RenderLine;
+void (*renderLine)() = gfxRenderLineSelect(0, false, 0);
 bool fxOn = false;
 bool windowOn = false;
 
+static void CPUDrawLine(MDFN_Surface *surface, int line);
+static void CPURenderLine(MDFN_Surface *surface, int line);
+
+// Reference point writes not yet passed to a line in gfxLineRegs.
+static int cpuBG2Changed = 0;
+static int cpuBG3Changed = 0;
+
+// Copies the display registers the next line is drawn with into r.
+static void CPULatchLine(gfxLineRegs *r)
+{
+  r->renderLine = renderLine;
+  r->layerEnable = layerEnable;
+  r->DISPCNT = DISPCNT;
+  r->BG0CNT = BG0CNT;
+  r->BG1CNT = BG1CNT;
+  r->BG2CNT = BG2CNT;
+  r->BG3CNT = BG3CNT;
+  memcpy(r->BGHOFS, BGHOFS, sizeof(r->BGHOFS));
+  memcpy(r->BGVOFS, BGVOFS, sizeof(r->BGVOFS));
+  r->BG2PA = BG2PA;
+  r->BG2PB = BG2PB;
+  r->BG2PC = BG2PC;
+  r->BG2PD = BG2PD;
+  r->BG2X_L = BG2X_L;
+  r->BG2X_H = BG2X_H;
+  r->BG2Y_L = BG2Y_L;
+  r->BG2Y_H = BG2Y_H;
+  r->BG3PA = BG3PA;
+  r->BG3PB = BG3PB;
+  r->BG3PC = BG3PC;
+  r->BG3PD = BG3PD;
+  r->BG3X_L = BG3X_L;
+  r->BG3X_H = BG3X_H;
+  r->BG3Y_L = BG3Y_L;
+  r->BG3Y_H = BG3Y_H;
+  r->WIN0H = WIN0H;
+  r->WIN1H = WIN1H;
+  r->WIN0V = WIN0V;
+  r->WIN1V = WIN1V;
+  r->WININ = WININ;
+  r->WINOUT = WINOUT;
+  r->MOSAIC = MOSAIC;
+  r->BLDMOD = BLDMOD;
+  r->COLEV = COLEV;
+  r->COLY = COLY;
+  r->BG2Changed = cpuBG2Changed;
+  r->BG3Changed = cpuBG3Changed;
+  cpuBG2Changed = cpuBG3Changed = 0;
+}
+
+// Threaded rendering.  With setting_gba_threaded_render on, the lines due
+// are queued to a thread that draws them in order while the CPU runs on.
+// Each queued line carries a copy of the display registers taken at its
+// time, so register writes go ahead without waiting.  A write to palette
+// RAM, VRAM or OAM, which the lines read in place, waits for the queue to
+// drain first (CPU_RENDER_SYNC).  The queue is drained at the end of every
+// frame as well.
+static bool cpuRenderThreadOn = false;
+static bool cpuRenderPending = false;
+
+#ifdef HAVE_RENDER_THREAD
+static pthread_t renderThread;
+static pthread_mutex_t renderMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t renderWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t renderIdle = PTHREAD_COND_INITIALIZER;
+static MDFN_Surface *renderSurface;
+static struct
+{
+  uint8 line;
+  gfxLineRegs regs;
+} renderLines[256];
+static uint32 renderHead, renderTail;
+static bool renderQuit;
+
+static void *CPURenderThread(void *arg)
+{
+  pthread_mutex_lock(&renderMutex);
+  for(;;)
+  {
+    while(renderHead == renderTail && !renderQuit)
+      pthread_cond_wait(&renderWake, &renderMutex);
+    if(renderHead == renderTail)
+      break;
+
+    const int line = renderLines[renderHead & 255].line;
+    gfxRegs = renderLines[renderHead & 255].regs;
+
+    pthread_mutex_unlock(&renderMutex);
+    CPURenderLine(renderSurface, line);
+    pthread_mutex_lock(&renderMutex);
+
+    if(++renderHead == renderTail)
+      pthread_cond_signal(&renderIdle);
+  }
+  pthread_mutex_unlock(&renderMutex);
+  return NULL;
+}
+
+static void CPURenderQueue(MDFN_Surface *surface, int line)
+{
+  pthread_mutex_lock(&renderMutex);
+  renderSurface = surface;
+  renderLines[renderTail & 255].line = line;
+  CPULatchLine(&renderLines[renderTail & 255].regs);
+  renderTail++;
+  // wake the thread a few lines at a time
+  if(!(renderTail & 3))
+    pthread_cond_signal(&renderWake);
+  pthread_mutex_unlock(&renderMutex);
+  cpuRenderPending = true;
+}
+
+static void CPURenderJoin(void)
+{
+  pthread_mutex_lock(&renderMutex);
+  pthread_cond_signal(&renderWake);
+  while(renderHead != renderTail)
+    pthread_cond_wait(&renderIdle, &renderMutex);
+  pthread_mutex_unlock(&renderMutex);
+  cpuRenderPending = false;
+}
+
+static void CPURenderThreadStart(void)
+{
+  renderHead = renderTail = 0;
+  renderQuit = false;
+  if(!pthread_create(&renderThread, NULL, CPURenderThread, NULL))
+    cpuRenderThreadOn = true;
+}
+
+static void CPURenderThreadStop(void)
+{
+  if(!cpuRenderThreadOn)
+    return;
+
+  pthread_mutex_lock(&renderMutex);
+  renderQuit = true;
+  pthread_cond_signal(&renderWake);
+  pthread_mutex_unlock(&renderMutex);
+  pthread_join(renderThread, NULL);
+  cpuRenderThreadOn = cpuRenderPending = false;
+}
+
+#define CPU_RENDER_SYNC() \
+  if(cpuRenderPending) \
+    CPURenderJoin();
+#else
+#define CPU_RENDER_SYNC()
+#endif
+
+// Unchanged frame skipping.  cpuFrameDirty is set by the writes that change
+// VRAM, OAM, palette RAM or the display registers and cleared as a frame
+// starts.  While neither it nor the flag of the previous frame is set, the
+// lines the previous frame left in the surface are kept instead of being
+// drawn again; cpuLinesSkipped counts them.
+static bool cpuFrameDirty = true;
+static bool cpuLastFrameDirty = true;
+static int cpuLinesSkipped = 0;
+
+// Surface of the frame Emulate() is running.
+static MDFN_Surface *cpuSurface = NULL;
+
+// Called ahead of the first change in a clean frame.  The renderers carry
+// state from line to line (the affine reference points), so the lines of
+// this frame skipped so far are drawn first.  Their output is the same as
+// the previous frame's, but the surface may be a frontend buffer that
+// doesn't hold it.
+static void CPUFrameChanged(void)
+{
+  CPU_RENDER_SYNC();
+  cpuFrameDirty = true;
+
+  if(cpuLinesSkipped && VCOUNT < 160)
+  {
+    for(int line = 0; line < cpuLinesSkipped; line++)
+      CPUDrawLine(cpuSurface, line);
+    cpuLinesSkipped = 0;
+  }
+}
+
+// Draws the next frame in full, for changes the write hooks don't see.
+static void CPURedrawFrame(void)
+{
+  CPU_RENDER_SYNC();
+  cpuFrameDirty = cpuLastFrameDirty = true;
+  cpuLinesSkipped = 0;
+}
+
 static const int TIMER_TICKS[4] =
 {
   0,
@@ -122,6 +329,7 @@ uint8 memoryWaitSeq[16] =
 uint8 memoryWaitSeq32[16] =
   { 0, 0, 5, 0, 0, 1, 1, 0, 5, 5, 9, 9, 17, 17, 4, 0 };
 
+
 // The videoMemoryWait constants are used to add some waitstates
 // if the opcode access video memory data outside of vblank/hblank
 // It seems to happen on only one ticks for each pixel.
@@ -144,68 +352,46 @@ union SysCM
  uint32 v32[65536];
  uint16 v16[65536];
 };
+// Only built for a CustomColorMap; the plain BGR555 conversion is done
+// with shifts by CPUConvertLine32/16().
 static SysCM* systemColorMap = NULL;
 static uint8 *CustomColorMap = NULL; // 32768 * 3
 static int romSize = 0x2000000;
 
 static INLINE int CPUUpdateTicks()
 {
-  int cpuLoopTicks = lcdTicks;
-
-  if(timers[0].On && (timers[0].Ticks < cpuLoopTicks)) {
-    cpuLoopTicks = timers[0].Ticks;
-  }
-  if(timers[1].On && !(timers[1].CNT & 4) && (timers[1].Ticks < cpuLoopTicks)) {
-    cpuLoopTicks = timers[1].Ticks;
-  }
-  if(timers[2].On && !(timers[2].CNT & 4) && (timers[2].Ticks < cpuLoopTicks)) {
-    cpuLoopTicks = timers[2].Ticks;
-  }
-  if(timers[3].On && !(timers[3].CNT & 4) && (timers[3].Ticks < cpuLoopTicks)) {
-    cpuLoopTicks = timers[3].Ticks;
-  }
+  int cpuLoopTicks = eventTicks();
 
   if (SWITicks) {
     if (SWITicks < cpuLoopTicks)
         cpuLoopTicks = SWITicks;
   }
-
-  if (IRQTicks) {
-    if (IRQTicks < cpuLoopTicks)
-        cpuLoopTicks = IRQTicks;
-  }
   return cpuLoopTicks;
 }
 
-void CPUUpdateWindow0()
+// Stores the count of a timer running off the event queue in D and ioMem,
+// where only stopped and count-up timers keep it.
+static void CPUSyncTimer(int n)
 {
-  int x00 = WIN0H>>8;
-  int x01 = WIN0H & 255;
-
-  if(x00 <= x01) {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin0[i] = (i >= x00 && i < x01);
-    }
-  } else {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin0[i] = (i >= x00 || i < x01);
-    }
+  if(eventPending(EVENT_TIMER0 + n)) {
+    timers[n].D = 0xFFFF - (CPUTimerTicksLeft(n, eventRemaining(EVENT_TIMER0 + n)) >> timers[n].ClockReload);
+    UPDATE_REG(0x100 + n * 4, timers[n].D);
   }
 }
 
-void CPUUpdateWindow1()
+// Timer 0 and timers that don't count up run off the event queue; while a
+// timer is not scheduled its Ticks holds the ticks left to its overflow.
+static void CPUUpdateTimerEvent(int n)
 {
-  int x00 = WIN1H>>8;
-  int x01 = WIN1H & 255;
-
-  if(x00 <= x01) {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin1[i] = (i >= x00 && i < x01);
-    }
-  } else {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin1[i] = (i >= x00 || i < x01);
-    }
+  const int id = EVENT_TIMER0 + n;
+
+  if(timers[n].On && (n == 0 || !(timers[n].CNT & 4))) {
+    if(!eventPending(id))
+      eventSchedule(id, timers[n].Ticks);
+  } else if(eventPending(id)) {
+    timers[n].Ticks = CPUTimerTicksLeft(n, eventRemaining(id));
+    timers[n].Batch = 0;
+    eventCancel(id);
   }
 }
 
@@ -243,6 +429,15 @@ static SFORMAT Joy_StateRegs[] =
 int StateAction(StateMem *sm, int load, int data_only)
 {
  int ret = 1;
+ int32 lcdTicks = eventRemaining(EVENT_LCD);
+
+ for(int i = 0; i < 4; i++)
+ {
+  if(eventPending(EVENT_TIMER0 + i))
+   timers[i].Ticks = CPUTimerTicksLeft(i, eventRemaining(EVENT_TIMER0 + i));
+  CPUSyncTimer(i);
+ }
+ CPUResolveFlags();
 
  SFORMAT StateRegs[] =
  {
@@ -399,8 +594,21 @@ int StateAction(StateMem *sm, int load, int data_only)
 
   CPUUpdateRender();
   CPUUpdateRenderBuffers(true);
-  CPUUpdateWindow0();
-  CPUUpdateWindow1();
+
+  CPUUpdateVRAMPages();
+  gfxTileCacheInvalidate();
+  gfxPaletteDirty = 0xFFFF;
+  gfxSpriteListsDirty = true;
+  CPURedrawFrame();
+  flagLazy = 0;
+
+  eventSchedule(EVENT_LCD, lcdTicks);
+  for(int i = 0; i < 4; i++)
+  {
+   eventCancel(EVENT_TIMER0 + i);
+   timers[i].Batch = 0;
+   CPUUpdateTimerEvent(i);
+  }
 
   if(armState) {
     ARM_PREFETCH;
@@ -565,6 +773,13 @@ static void CPUCleanUp(void)
 
 void CloseGame(void)
 {
+ MDFN_printf("Halted:    %llu cycles skipped, %llu timer overflows batched\n",
+             (unsigned long long)cpuHaltTicks, (unsigned long long)cpuHaltOverflows);
+
+#ifdef HAVE_RENDER_THREAD
+ CPURenderThreadStop();
+#endif
+
  if (use_mednafen_save_method)
  {
    EEPROM_SaveFile(MDFN_MakeFName(MDFNMKF_SAV, 0, "eep").c_str());
@@ -578,6 +793,11 @@ void CloseGame(void)
 static void RedoColorMap(const MDFN_PixelFormat &format) MDFN_COLD;
 static void RedoColorMap(const MDFN_PixelFormat &format)
 {
+ CPURedrawFrame();
+
+ if(!systemColorMap)
+  return;
+
  for(int x = 0; x < 65536; x++)
  {
   int r, g, b;
@@ -667,6 +887,9 @@ int Load(const uint8_t *data, size_t size)
 #endif
    MDFN_printf(_("ROM MD5:   0x%s\n"), md5_context::asciistr(MDFNGameInfo->MD5, 0).c_str());
 
+   MP2K_Detect(whereToLoad, size);
+   cpuHaltTicks = cpuHaltOverflows = 0;
+
    uint16 *temp = (uint16 *)(rom+((size+1)&~1));
    int i;
 
@@ -713,7 +936,7 @@ int Load(const uint8_t *data, size_t size)
    return 0;
   }
 
-  if(!(systemColorMap = (SysCM*)malloc(sizeof(SysCM))))
+  if(CustomColorMap && !(systemColorMap = (SysCM*)malloc(sizeof(SysCM))))
   {
    CPUCleanUp();
    return(0);
@@ -773,68 +996,21 @@ void doMirroring (bool b)
 
 static void CPUUpdateRender(void)
 {
-  switch(DISPCNT & 7) {
-  case 0:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode0RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode0RenderLineNoWindow;
-    else
-      renderLine = mode0RenderLineAll;
-    break;
-  case 1:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode1RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode1RenderLineNoWindow;
-    else
-      renderLine = mode1RenderLineAll;
-    break;
-  case 2:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode2RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode2RenderLineNoWindow;
-    else
-      renderLine = mode2RenderLineAll;
-    break;
-  case 3:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode3RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode3RenderLineNoWindow;
-    else
-      renderLine = mode3RenderLineAll;
-    break;
-  case 4:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode4RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode4RenderLineNoWindow;
-    else
-      renderLine = mode4RenderLineAll;
-    break;
-  case 5:
-    if((!fxOn && !windowOn && !(layerEnable & 0x8000)) ||
-       cpuDisableSfx)
-      renderLine = mode5RenderLine;
-    else if(fxOn && !windowOn && !(layerEnable & 0x8000))
-      renderLine = mode5RenderLineNoWindow;
-    else
-      renderLine = mode5RenderLineAll;
-  default:
-    break;
-  }
+  bool window = windowOn || (layerEnable & 0x8000);
+
+  if((DISPCNT & 7) > 5)
+    return;
+
+  if(cpuDisableSfx)
+    renderLine = gfxRenderLineSelect(DISPCNT & 7, false, 0);
+  else
+    renderLine = gfxRenderLineSelect(DISPCNT & 7, window, (BLDMOD >> 6) & 3);
 }
 
 void CPUUpdateCPSR()
 {
   uint32 CPSR = reg[16].I & 0x40;
+  CPUResolveFlags();
   if(N_FLAG)
     CPSR |= 0x80000000;
   if(Z_FLAG)
@@ -859,6 +1035,7 @@ void CPUUpdateFlags(bool breakLoop)
   Z_FLAG = (CPSR & 0x40000000) ? true: false;
   C_FLAG = (CPSR & 0x20000000) ? true: false;
   V_FLAG = (CPSR & 0x10000000) ? true: false;
+  flagLazy = 0;
   armState = (CPSR & 0x20) ? false : true;
   armIrqEnable = (CPSR & 0x80) ? false : true;
   if(breakLoop) {
@@ -1038,6 +1215,7 @@ void CPUSoftwareInterrupt()
 void CPUSoftwareInterrupt(int comment)
 {
   static bool disableMessage = true;
+  cpuIdleLoopActivity++;
   if(armState) comment >>= 16;
   if(comment == 0xfa) {
     return;
@@ -1268,8 +1446,89 @@ static void CPUCompareVCOUNT()
   {
       layerEnableDelay--;
       if (layerEnableDelay==1)
+      {
+          if(!cpuFrameDirty && layerEnable != (layerSettings & DISPCNT))
+            CPUFrameChanged();
           layerEnable = layerSettings & DISPCNT;
+      }
+  }
+}
+
+// Copies the leading units of a DMA that are plain memory on both sides
+// (ROM, RAM, palette, VRAM, OAM) in one go, for increment destinations
+// with an increment or fixed source.  Returns the number of units
+// copied, 0 when the next unit has to go through the memory handlers.
+static uint32 CPUDmaBulk(uint32 &s, uint32 &d, uint32 si, uint32 di, uint32 c, uint32 size)
+{
+  if(di != size || (si != size && si != 0) || s >= 0x10000000 || d >= 0x10000000)
+    return 0;
+
+  const memoryMap &sp = memoryReadPages[s >> MEMORY_PAGE_SHIFT];
+  const memoryMap &dp = memoryWritePages[d >> MEMORY_PAGE_SHIFT];
+
+  if(!sp.address || !dp.address)
+    return 0;
+
+  // stay within the page and the mirror of each side
+  const uint32 smask = sp.mask & ((1 << MEMORY_PAGE_SHIFT) - 1);
+  const uint32 dmask = dp.mask & ((1 << MEMORY_PAGE_SHIFT) - 1);
+  const uint32 sa = s & sp.mask & ~(size - 1);
+  const uint32 da = d & dp.mask & ~(size - 1);
+  uint32 n = (dmask + 1 - (da & dmask)) / size;
+
+  if(si && n > (smask + 1 - (sa & smask)) / size)
+    n = (smask + 1 - (sa & smask)) / size;
+  if(n > c)
+    n = c;
+
+  const uint8 *src = sp.address + sa;
+  uint8 *dst = dp.address + da;
+  const uint32 len = n * size;
+  // DMAs that rewrite palette RAM, VRAM or OAM with what it holds already,
+  // like OAM uploads every frame, leave the frame clean.
+  bool changed = (d >> 24) < 5;
+
+  if(!si)
+  {
+    uint8 unit[4];
+
+    memcpy(unit, src, size);
+    for(uint32 i = 0; i < len && !changed; i += size)
+      changed = memcmp(dst + i, unit, size) != 0;
+    if(changed)
+    {
+      CPUHostWritten(d, len);
+      for(uint32 i = 0; i < len; i += size)
+        memcpy(dst + i, unit, size);
+    }
+  }
+  else
+  {
+    // a forward copy onto itself replicates, which memcpy won't
+    if(src < dst + len && dst < src + len)
+      return 0;
+    if(changed || memcmp(dst, src, len))
+    {
+      changed = true;
+      CPUHostWritten(d, len);
+      memcpy(dst, src, len);
+    }
+  }
+
+  if(size == 4)
+    cpuDmaLast = READ32LE((uint32 *)(dst + len - 4));
+  else
+  {
+    cpuDmaLast = READ16LE((uint16 *)(dst + len - 2));
+    cpuDmaLast |= cpuDmaLast << 16;
   }
+
+  if(!changed)
+    cpuIdleLoopActivity++;
+
+  s += si * n;
+  d += len;
+  return n;
 }
 
 #define doDMA(s, d, _si, _di, _c, _transfer32)	\
@@ -1297,6 +1556,11 @@ static void CPUCompareVCOUNT()
       }	\
     } else {	\
       while(c != 0) {	\
+        uint32 n = CPUDmaBulk(s, d, si, di, c, 4);	\
+        if(n) {	\
+          c -= n;	\
+          continue;	\
+        }	\
         cpuDmaLast = CPUReadMemory(s);	\
         CPUWriteMemory(d, cpuDmaLast);	\
         d += di;	\
@@ -1316,6 +1580,11 @@ static void CPUCompareVCOUNT()
       }	\
     } else {	\
       while(c != 0) {	\
+        uint32 n = CPUDmaBulk(s, d, si, di, c, 2);	\
+        if(n) {	\
+          c -= n;	\
+          continue;	\
+        }	\
         cpuDmaLast = CPUReadHalfWord(s);	\
         CPUWriteHalfWord(d, cpuDmaLast);	\
         cpuDmaLast |= (cpuDmaLast<<16);	\
@@ -1544,17 +1813,29 @@ void CPUCheckDMA(int reason, int dmamask)
 
 void CPUUpdateRegister(uint32 address, uint16 value)
 {
+  // The display registers, but for DISPSTAT and VCOUNT.  A write to a
+  // reference point restarts it even with the same value.
+  if(address < 0x56 && (address & ~3) != 0x04)
+  {
+    if(!cpuFrameDirty &&
+       (READ16LE((uint16 *)&ioMem[address]) != value || (address >= 0x28 && address < 0x30) ||
+        (address >= 0x38 && address < 0x40)))
+      CPUFrameChanged();
+  }
+
   switch(address)
   {
   case 0x00:
     {
+      const uint16 oldMode = DISPCNT & 7;
       if ((value & 7) >5)
           DISPCNT = (value &7);
       bool change = ((DISPCNT ^ value) & 0x80) ? true : false;
-      bool changeBG = ((DISPCNT ^ value) & 0x0F00) ? true : false;
       uint16 changeBGon = (((~DISPCNT) & value) & 0x0F00);
       DISPCNT = (value & 0xFFF7);
       UPDATE_REG(0x00, DISPCNT);
+      if((DISPCNT & 7) != oldMode)
+        CPUUpdateVRAMPages();
 
       if (changeBGon)
       {
@@ -1568,7 +1849,7 @@ void CPUUpdateRegister(uint32 address, uint16 value)
       windowOn = (layerEnable & 0x6000) ? true : false;
       if(change && !((value & 0x80))) {
         if(!(DISPSTAT & 1)) {
-          lcdTicks = 1008;
+          eventSchedule(EVENT_LCD, 1008);
           //      VCOUNT = 0;
           //      UPDATE_REG(0x06, VCOUNT);
           DISPSTAT &= 0xFFFC;
@@ -1578,9 +1859,6 @@ void CPUUpdateRegister(uint32 address, uint16 value)
         //        (*renderLine)();
       }
       CPUUpdateRender();
-      // we only care about changes in BG0-BG3
-      if(changeBG)
-        CPUUpdateRenderBuffers(false);
     }
     break;
   case 0x04:
@@ -1657,22 +1935,22 @@ void CPUUpdateRegister(uint32 address, uint16 value)
   case 0x28:
     BG2X_L = value;
     UPDATE_REG(0x28, BG2X_L);
-    gfxBG2Changed |= 1;
+    cpuBG2Changed |= 1;
     break;
   case 0x2A:
     BG2X_H = (value & 0xFFF);
     UPDATE_REG(0x2A, BG2X_H);
-    gfxBG2Changed |= 1;
+    cpuBG2Changed |= 1;
     break;
   case 0x2C:
     BG2Y_L = value;
     UPDATE_REG(0x2C, BG2Y_L);
-    gfxBG2Changed |= 2;
+    cpuBG2Changed |= 2;
     break;
   case 0x2E:
     BG2Y_H = value & 0xFFF;
     UPDATE_REG(0x2E, BG2Y_H);
-    gfxBG2Changed |= 2;
+    cpuBG2Changed |= 2;
     break;
   case 0x30:
     BG3PA = value;
@@ -1693,32 +1971,30 @@ void CPUUpdateRegister(uint32 address, uint16 value)
   case 0x38:
     BG3X_L = value;
     UPDATE_REG(0x38, BG3X_L);
-    gfxBG3Changed |= 1;
+    cpuBG3Changed |= 1;
     break;
   case 0x3A:
     BG3X_H = value & 0xFFF;
     UPDATE_REG(0x3A, BG3X_H);
-    gfxBG3Changed |= 1;
+    cpuBG3Changed |= 1;
     break;
   case 0x3C:
     BG3Y_L = value;
     UPDATE_REG(0x3C, BG3Y_L);
-    gfxBG3Changed |= 2;
+    cpuBG3Changed |= 2;
     break;
   case 0x3E:
     BG3Y_H = value & 0xFFF;
     UPDATE_REG(0x3E, BG3Y_H);
-    gfxBG3Changed |= 2;
+    cpuBG3Changed |= 2;
     break;
   case 0x40:
     WIN0H = value;
     UPDATE_REG(0x40, WIN0H);
-    CPUUpdateWindow0();
     break;
   case 0x42:
     WIN1H = value;
     UPDATE_REG(0x42, WIN1H);
-    CPUUpdateWindow1();
     break;
   case 0x44:
     WIN0V = value;
@@ -2044,6 +2320,7 @@ void applyTimer ()
 {
   if (timerOnOffDelay & 1)
   {
+    CPUSyncTimer(0);
     timers[0].ClockReload = TIMER_TICKS[timers[0].Value & 3];
     if(!timers[0].On && (timers[0].Value & 0x80)) {
       // reload the counter
@@ -2054,10 +2331,12 @@ void applyTimer ()
     timers[0].On = timers[0].Value & 0x80 ? true : false;
     timers[0].CNT = timers[0].Value & 0xC7;
     UPDATE_REG(0x102, timers[0].CNT);
+    CPUUpdateTimerEvent(0);
     //    CPUUpdateTicks();
   }
   if (timerOnOffDelay & 2)
   {
+    CPUSyncTimer(1);
     timers[1].ClockReload = TIMER_TICKS[timers[1].Value & 3];
     if(!timers[1].On && (timers[1].Value & 0x80)) {
       // reload the counter
@@ -2068,9 +2347,11 @@ void applyTimer ()
     timers[1].On = timers[1].Value & 0x80 ? true : false;
     timers[1].CNT = timers[1].Value & 0xC7;
     UPDATE_REG(0x106, timers[1].CNT);
+    CPUUpdateTimerEvent(1);
   }
   if (timerOnOffDelay & 4)
   {
+    CPUSyncTimer(2);
     timers[2].ClockReload = TIMER_TICKS[timers[2].Value & 3];
     if(!timers[2].On && (timers[2].Value & 0x80)) {
       // reload the counter
@@ -2081,9 +2362,11 @@ void applyTimer ()
     timers[2].On = timers[2].Value & 0x80 ? true : false;
     timers[2].CNT = timers[2].Value & 0xC7;
     UPDATE_REG(0x10A, timers[2].CNT);
+    CPUUpdateTimerEvent(2);
   }
   if (timerOnOffDelay & 8)
   {
+    CPUSyncTimer(3);
     timers[3].ClockReload = TIMER_TICKS[timers[3].Value & 3];
     if(!timers[3].On && (timers[3].Value & 0x80)) {
       // reload the counter
@@ -2094,6 +2377,7 @@ void applyTimer ()
     timers[3].On = timers[3].Value & 0x80 ? true : false;
     timers[3].CNT = timers[3].Value & 0xC7;
     UPDATE_REG(0x10E, timers[3].CNT);
+    CPUUpdateTimerEvent(3);
   }
   cpuNextEvent = CPUUpdateTicks();
   timerOnOffDelay = 0;
@@ -2121,8 +2405,69 @@ static void FLASH_SRAM_Write(uint32 A, uint32 V)
  flashWrite(A, V);
 }
 
+// Ahead of a write to a page of the direct write table.  Writes to palette
+// RAM, VRAM and OAM dirty the frame if changed, VRAM ones the decoded tiles
+// and OAM ones the sprite lists; EWRAM and IWRAM writes need nothing.
+#define CPU_PAGE_WRITE(address, changed) \
+  if((address >> 25) != 1) \
+  { \
+    CPU_RENDER_SYNC(); \
+    if(!cpuFrameDirty && (changed)) \
+      CPUFrameChanged(); \
+    if((address >> 24) == 6) \
+      gfxVramWritten((address & 0x10000) ? (address & 0x17FFF) : (address & 0xFFFF)); \
+    else if((address >> 24) == 7) \
+      gfxOamWritten(address); \
+    else if((address >> 24) == 5) \
+      gfxPaletteWritten(address & 0x3FF); \
+  }
+
+uint32 CPUHostSpan(const memoryMap *pages, uint32 address, uint32 max, uint8 **host)
+{
+  uint32 span = 0;
+
+  *host = NULL;
+  while(span < max && address + span < 0x10000000)
+  {
+    const uint32 a = address + span;
+    const memoryMap &page = pages[a >> MEMORY_PAGE_SHIFT];
+    const uint32 mask = page.mask & ((1 << MEMORY_PAGE_SHIFT) - 1);
+
+    if(!page.address)
+      break;
+    if(!span)
+      *host = page.address + (a & page.mask);
+    else if(page.address + (a & page.mask) != *host + span)
+      break;
+    span += mask + 1 - (a & mask);
+  }
+  return span < max ? span : max;
+}
+
+void CPUHostWritten(uint32 address, uint32 len)
+{
+  cpuIdleLoopActivity++;
+
+  if((address >> 24) >= 5 && (address >> 24) <= 7)
+  {
+    for(uint32 a = address & ~0x1F; a < address + len; a += 0x20)
+      CPU_PAGE_WRITE(a, true);
+  }
+}
+
 void CPUWriteMemory(uint32 address, uint32 value)
 {
+ cpuIdleLoopActivity++;
+
+ if(address < 0x10000000 && memoryWritePages[address >> MEMORY_PAGE_SHIFT].address)
+ {
+  const memoryMap &page = memoryWritePages[address >> MEMORY_PAGE_SHIFT];
+  uint32 *p = (uint32 *)&page.address[address & page.mask & ~3];
+  CPU_PAGE_WRITE(address, READ32LE(p) != value);
+  WRITE32LE(p, value);
+  return;
+ }
+
  switch(address >> 24)
  {
   case 0x02:
@@ -2138,7 +2483,11 @@ void CPUWriteMemory(uint32 address, uint32 value)
     }   \
     break;      \
   case 0x05:    \
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && READ32LE(((uint32 *)&paletteRAM[address & 0x3FC])) != value)
+      CPUFrameChanged();
     WRITE32LE(((uint32 *)&paletteRAM[address & 0x3FC]), value); \
+    gfxPaletteWritten(address & 0x3FC); \
     break;      \
   case 0x06:    \
     address = (address & 0x1fffc);
@@ -2146,11 +2495,19 @@ void CPUWriteMemory(uint32 address, uint32 value)
      return;
     if ((address & 0x18000) == 0x18000)
      address &= 0x17fff;
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && READ32LE(((uint32 *)&vram[address])) != value)
+      CPUFrameChanged();
     WRITE32LE(((uint32 *)&vram[address]), value);
+    gfxVramWritten(address);
     break;      \
 
   case 0x07:
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && READ32LE(((uint32 *)&oam[address & 0x3fc])) != value)
+      CPUFrameChanged();
     WRITE32LE(((uint32 *)&oam[address & 0x3fc]), value);
+    gfxOamWritten(address);
     break;
 
   case 0x0D:
@@ -2171,6 +2528,17 @@ void CPUWriteMemory(uint32 address, uint32 value)
 
 void CPUWriteHalfWord(uint32 address, uint16 value)
 {
+ cpuIdleLoopActivity++;
+
+ if(address < 0x10000000 && memoryWritePages[address >> MEMORY_PAGE_SHIFT].address)
+ {
+  const memoryMap &page = memoryWritePages[address >> MEMORY_PAGE_SHIFT];
+  uint16 *p = (uint16 *)&page.address[address & page.mask & ~1];
+  CPU_PAGE_WRITE(address, READ16LE(p) != value);
+  WRITE16LE(p, value);
+  return;
+ }
+
  switch(address >> 24)
  {
   case 2:
@@ -2185,7 +2553,11 @@ void CPUWriteHalfWord(uint32 address, uint16 value)
     else goto unwritable;
     break;
   case 5:
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && READ16LE(((uint16 *)&paletteRAM[address & 0x3fe])) != value)
+      CPUFrameChanged();
     WRITE16LE(((uint16 *)&paletteRAM[address & 0x3fe]), value);
+    gfxPaletteWritten(address & 0x3fe);
     break;
   case 6:
      address = (address & 0x1fffe);
@@ -2193,10 +2565,18 @@ void CPUWriteHalfWord(uint32 address, uint16 value)
       return;
      if ((address & 0x18000) == 0x18000)
       address &= 0x17fff;
+     CPU_RENDER_SYNC();
+     if(!cpuFrameDirty && READ16LE(((uint16 *)&vram[address])) != value)
+       CPUFrameChanged();
      WRITE16LE(((uint16 *)&vram[address]), value);
+     gfxVramWritten(address);
     break;
   case 7:
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && READ16LE(((uint16 *)&oam[address & 0x3fe])) != value)
+      CPUFrameChanged();
     WRITE16LE(((uint16 *)&oam[address & 0x3fe]), value);
+    gfxOamWritten(address);
     break;
   case 8:
   case 9:
@@ -2225,6 +2605,17 @@ void CPUWriteHalfWord(uint32 address, uint16 value)
 
 void CPUWriteByte(uint32 address, uint8 b)
 {
+ cpuIdleLoopActivity++;
+
+ // byte writes to palette RAM, VRAM and OAM are special, see below
+ if((address >> 25) == 1)
+ {
+  const memoryMap &page = memoryWritePages[address >> MEMORY_PAGE_SHIFT];
+  CPU_PAGE_WRITE(address, true);
+  page.address[address & page.mask] = b;
+  return;
+ }
+
  switch(address >> 24)
  {
   case 2:
@@ -2305,7 +2696,11 @@ void CPUWriteByte(uint32 address, uint8 b)
     break;
   case 5:
     // no need to switch
+    CPU_RENDER_SYNC();
+    if(!cpuFrameDirty && *((uint16 *)&paletteRAM[address & 0x3FE]) != ((b << 8) | b))
+      CPUFrameChanged();
     *((uint16 *)&paletteRAM[address & 0x3FE]) = (b << 8) | b;
+    gfxPaletteWritten(address & 0x3FE);
     break;
   case 6:
     address = (address & 0x1fffe);
@@ -2316,7 +2711,13 @@ void CPUWriteByte(uint32 address, uint8 b)
     // no need to switch
     // byte writes to OBJ VRAM are ignored
     if ((address) < objTilesAddress[((DISPCNT&7)+1)>>2])
+    {
+     CPU_RENDER_SYNC();
+     if(!cpuFrameDirty && *((uint16 *)&vram[address]) != ((b << 8) | b))
+       CPUFrameChanged();
      *((uint16 *)&vram[address]) = (b << 8) | b;
+     gfxVramWritten(address);
+    }
     break;
   case 7:
     // no need to switch
@@ -2462,6 +2863,22 @@ static const ini_t gbaover[256] = {
    {"Zoku Bokura no Taiyou - Taiyou Shounen Django (Japan)",		"U32J",	0,	0,	1,	0,	0}
 };
 
+// Heads of busy-wait loops that store to memory while waiting, which keeps
+// the automatic detection in CPULoop() from treating them as idle.  The
+// register state still has to repeat before such a loop is skipped.
+typedef struct {
+   char romid[5];
+   uint32 pc;
+} idleloop_t;
+
+static const idleloop_t gbaidleloops[] = {
+   //romid	loop
+   {"AWRE",	0x08038810},	// Advance Wars (USA)
+   {"AWRP",	0x08038810},	// Advance Wars (Europe)
+   {"AW2E",	0x08036E08},	// Advance Wars 2 - Black Hole Rising (USA)
+   {"AW2P",	0x0803719C},	// Advance Wars 2 - Black Hole Rising (Europe)
+};
+
 uint8 cpuBitsSet[256];
 uint8 cpuLowestBitSet[256];
 
@@ -2487,6 +2904,16 @@ static bool CPUInit(const std::string bios_fn)
 
  MDFN_printf("GameID:    %s\n", buffer);
 
+ idleLoopOverride = 0;
+ for(unsigned i = 0; i < sizeof(gbaidleloops) / sizeof(gbaidleloops[0]); i++)
+ {
+  if(!strcmp(gbaidleloops[i].romid, buffer))
+  {
+   idleLoopOverride = gbaidleloops[i].pc;
+   MDFN_printf("Idle loop: %08x\n", idleLoopOverride);
+  }
+ }
+
  if(memfp)
  {
   char linebuffer[256];
@@ -2737,6 +3164,58 @@ static bool CPUInit(const std::string bios_fn)
  return(1);
 }
 
+// VRAM is mirrored every 128 KiB, with its last 32 KiB repeating the 32 KiB
+// before them.  In the bitmap modes 0x18000-0x1BFFF is not mapped.
+static void CPUUpdateVRAMPages(void)
+{
+  const bool bitmap = (DISPCNT & 7) > 2;
+
+  for(uint32 page = 0x06000000 >> MEMORY_PAGE_SHIFT; page < (0x07000000 >> MEMORY_PAGE_SHIFT); page++)
+  {
+    uint32 address = (page << MEMORY_PAGE_SHIFT) & 0x1FFFF;
+    memoryMap m = { NULL, 0 };
+
+    if(!bitmap || (address & 0x1C000) != 0x18000)
+    {
+      if((address & 0x18000) == 0x18000)
+        address &= 0x17FFF;
+      m.address = vram + address;
+      m.mask = (1 << MEMORY_PAGE_SHIFT) - 1;
+    }
+    memoryReadPages[page] = memoryWritePages[page] = m;
+  }
+}
+
+// Fills the page tables.  BIOS, I/O, save media and the RTC registers are
+// always left to the handlers, and so are writes to ROM.
+static void CPUUpdateMemoryPages(void)
+{
+  for(uint32 page = 0; page < MEMORY_PAGES; page++)
+  {
+    memoryMap m = { NULL, 0 };
+
+    switch(page >> (24 - MEMORY_PAGE_SHIFT))
+    {
+      case 2: m.address = workRAM; m.mask = 0x3FFFF; break;
+      case 3: m.address = internalRAM; m.mask = 0x7FFF; break;
+      case 5: m.address = paletteRAM; m.mask = 0x3FF; break;
+      case 7: m.address = oam; m.mask = 0x3FF; break;
+    }
+    memoryReadPages[page] = memoryWritePages[page] = m;
+
+    if(page >= (0x08000000 >> MEMORY_PAGE_SHIFT) && page < (0x0D000000 >> MEMORY_PAGE_SHIFT))
+    {
+      memoryReadPages[page].address = rom;
+      memoryReadPages[page].mask = 0x1FFFFFF;
+    }
+  }
+
+  if(GBA_RTC)
+    memoryReadPages[0x08000000 >> MEMORY_PAGE_SHIFT].address = NULL;
+
+  CPUUpdateVRAMPages();
+}
+
 static void CPUReset(void) MDFN_COLD;
 static void CPUReset(void)
 {
@@ -2751,6 +3230,10 @@ static void CPUReset(void)
   memset(paletteRAM, 0, 0x400);
   // clean vram
   memset(vram, 0, 0x20000);
+  gfxTileCacheInvalidate();
+  gfxPaletteDirty = 0xFFFF;
+  gfxSpriteListsDirty = true;
+  CPURedrawFrame();
   // clean io memory
   memset(ioMem, 0, 0x400);
 
@@ -2841,6 +3324,7 @@ static void CPUReset(void)
   V_FLAG = false;
   N_FLAG = false;
   Z_FLAG = false;
+  flagLazy = 0;
 
   UPDATE_REG(0x00, DISPCNT);
   UPDATE_REG(0x06, VCOUNT);
@@ -2868,12 +3352,14 @@ static void CPUReset(void)
   biosProtected[2] = 0x29;
   biosProtected[3] = 0xe1;
 
-  lcdTicks = (useBios && !skipBios) ? 1008 : 208;
+  eventReset();
+  eventSchedule(EVENT_LCD, (useBios && !skipBios) ? 1008 : 208);
 
   for(int i = 0; i < 4; i++)
   {
    timers[i].On = false;
    timers[i].Ticks = 0;
+   timers[i].Batch = 0;
    timers[i].Reload = 0;
    timers[i].ClockReload  = 0;
   }
@@ -2887,7 +3373,7 @@ static void CPUReset(void)
   dmaSource[3] = 0;
   dmaDest[3] = 0;
 
-  renderLine = mode0RenderLine;
+  renderLine = gfxRenderLineSelect(0, false, 0);
   fxOn = false;
   windowOn = false;
   saveType = 0;
@@ -2925,14 +3411,13 @@ static void CPUReset(void)
   map[14].address = flashSaveMemory;
   map[14].mask = 0xFFFF;
 
+  CPUUpdateMemoryPages();
+
   EEPROM_Reset();
   Flash_Reset();
 
   soundReset();
 
-  CPUUpdateWindow0();
-  CPUUpdateWindow1();
-
   // make sure registers are correctly initialized if not using BIOS
   if(!useBios) {
     if(cpuIsMultiBoot)
@@ -2992,34 +3477,370 @@ int32 MDFNGBA_GetTimerPeriod(int which)
 static int frameready;
 static int HelloSkipper;
 
+// Called after a short backward jump.  Returns true when the loop starting
+// at armNextPC went through a whole iteration since its last arrival without
+// changing the CPU state or touching memory; nothing can then change before
+// the next event, so the rest of the wait can be skipped.  The CPU state is
+// only taken once the loop came back without any memory activity, and the
+// pending flag operands are compared as they are, without resolving them.
+bool CPUIdleLoop(void)
+{
+  if(armNextPC != idleLoopPC ||
+     (cpuIdleLoopActivity != idleLoopSeen && armNextPC != idleLoopOverride)) {
+    idleLoopPC = armNextPC;
+    idleLoopSeen = cpuIdleLoopActivity;
+    idleLoopStateValid = false;
+    return false;
+  }
+
+  uint32 state[21];
+
+  for(int i = 0; i < 16; i++)
+    state[i] = reg[i].I;
+  state[16] = N_FLAG;
+  state[17] = flagLhs;
+  state[18] = flagRhs;
+  state[19] = flagRes;
+  state[20] = Z_FLAG | (C_FLAG << 1) | (V_FLAG << 2) | (armState << 3) | (flagLazy << 4);
+
+  bool idle = idleLoopStateValid && !memcmp(state, idleLoopState, sizeof(state));
+
+  idleLoopSeen = cpuIdleLoopActivity;
+  idleLoopStateValid = true;
+  memcpy(idleLoopState, state, sizeof(state));
+  return idle;
+}
+
+// Raises the overflow of timer n and clocks the next timer if it counts up.
+static void CPUTimerOverflow(int n)
+{
+  if(n < 2)
+    soundTimerOverflow(n);
+  if(timers[n].CNT & 0x40) {
+    IF |= 0x08 << n;
+    UPDATE_REG(0x202, IF);
+  }
+
+  if(n < 3 && timers[n + 1].On && (timers[n + 1].CNT & 4)) {
+    timers[n + 1].D++;
+    if(timers[n + 1].D == 0) {
+      timers[n + 1].D += timers[n + 1].Reload;
+      CPUTimerOverflow(n + 1);
+    }
+    UPDATE_REG(0x104 + n * 4, timers[n + 1].D);
+  }
+}
+
+// Whether nothing but the IF bit sees the overflows of timer n: its IRQ is
+// masked, Direct Sound doesn't take samples on it and no timer counts it.
+static bool CPUTimerSilent(int n)
+{
+  if(n < 2 && soundTimerUsed(n))
+    return false;
+  if((timers[n].CNT & 0x40) && (IE & (0x08 << n)))
+    return false;
+  return n == 3 || !(timers[n + 1].On && (timers[n + 1].CNT & 4));
+}
+
+static void CPUTimerEvent(int n)
+{
+  const int id = EVENT_TIMER0 + n;
+  const int32 period = (0x10000 - timers[n].Reload) << timers[n].ClockReload;
+  int32 next = eventRemaining(id) + period;
+
+  timers[n].Batch = 0;
+
+  // A halted CPU only wakes on an event that can raise an enabled IRQ, so
+  // the overflows of a silent timer up to the first of those run as one.
+  if(holdState && CPUTimerSilent(n)) {
+    int32 wake = eventRemaining(EVENT_LCD);
+
+    for(int i = EVENT_IRQ; i <= EVENT_TIMER3; i++) {
+      if(i != id && eventPending(i) && eventRemaining(i) < wake &&
+         (i < EVENT_TIMER0 || !CPUTimerSilent(i - EVENT_TIMER0)))
+        wake = eventRemaining(i);
+    }
+
+    if(next < wake) {
+      const int32 batched = (wake - next + period - 1) / period;
+
+      next += batched * period;
+      timers[n].Batch = period;
+      cpuHaltOverflows += batched;
+    }
+  }
+
+  eventSchedule(id, next);
+  CPUTimerOverflow(n);
+}
+
+// BGR555 to the 32-bit surface format, each component scaled up by 8.
+static INLINE uint32 CPUColor32(uint32 c)
+{
+  return ((c & 0x001F) << (RED_SHIFT + 3)) | (((c >> 5) & 0x1F) << (GREEN_SHIFT + 3)) |
+         (((c >> 10) & 0x1F) << (BLUE_SHIFT + 3));
+}
+
+// BGR555 to RGB565 or RGB555, the green of RGB565 extended to 6 bits as
+// (g * 255 + 15) / 31 >> 2 does.
+static INLINE uint16 CPUColor16(uint32 c)
+{
+  const uint32 r = c & 0x1F, g = (c >> 5) & 0x1F, b = (c >> 10) & 0x1F;
+
+#if defined(WANT_16BPP) && !defined(FRONTEND_SUPPORTS_RGB565)
+  return (r << 10) | (g << 5) | b;
+#else
+  return (r << 11) | (((g << 1) | (g >> 4)) << 5) | b;
+#endif
+}
+
+static void CPUConvertLine32(uint32 *dest, const uint32 *src)
+{
+  int x = 0;
+
+#if defined(__SSE2__) && defined(WANT_32BPP)
+  const __m128i mask = _mm_set1_epi32(0x1F);
+
+  for(; x < 240; x += 4)
+  {
+    const __m128i c = _mm_load_si128((const __m128i *)&src[x]);
+    const __m128i r = _mm_slli_epi32(_mm_and_si128(c, mask), RED_SHIFT + 3);
+    const __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(c, 5), mask), GREEN_SHIFT + 3);
+    const __m128i b = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(c, 10), mask), BLUE_SHIFT + 3);
+
+    _mm_storeu_si128((__m128i *)&dest[x], _mm_or_si128(_mm_or_si128(r, g), b));
+  }
+#endif
+  for(; x < 240; x++)
+    dest[x] = CPUColor32(src[x]);
+}
+
+static void CPUConvertLine16(uint16 *dest, const uint32 *src)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi16(0x1F);
+  const __m128i color = _mm_set1_epi32(0x7FFF);
+
+  for(; x < 240; x += 8)
+  {
+    // with the priority bits off the pack doesn't saturate
+    const __m128i lo = _mm_and_si128(_mm_load_si128((const __m128i *)&src[x]), color);
+    const __m128i hi = _mm_and_si128(_mm_load_si128((const __m128i *)&src[x + 4]), color);
+    const __m128i c = _mm_packs_epi32(lo, hi);
+    const __m128i r = _mm_and_si128(c, mask);
+    const __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask);
+    const __m128i b = _mm_srli_epi16(c, 10);
+#if defined(WANT_16BPP) && !defined(FRONTEND_SUPPORTS_RGB565)
+    const __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10), _mm_slli_epi16(g, 5)), b);
+#else
+    const __m128i g6 = _mm_or_si128(_mm_slli_epi16(g, 1), _mm_srli_epi16(g, 4));
+    const __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g6, 5)), b);
+#endif
+
+    _mm_storeu_si128((__m128i *)&dest[x], out);
+  }
+#endif
+  for(; x < 240; x++)
+    dest[x] = CPUColor16(src[x]);
+}
+
+static void CPUDrawLine(MDFN_Surface *surface, int line)
+{
+  CPULatchLine(&gfxRegs);
+  CPURenderLine(surface, line);
+}
+
+// Draws line from the registers in gfxRegs.
+static void CPURenderLine(MDFN_Surface *surface, int line)
+{
+  const uint32 *src = lineMix;
+
+  gfxVCOUNT = line;
+  gfxBG2Changed |= gfxRegs.BG2Changed;
+  gfxBG3Changed |= gfxRegs.BG3Changed;
+  (*gfxRegs.renderLine)();
+
+  if(!systemColorMap) {
+    if(surface->format.bpp == 32)
+      CPUConvertLine32(surface->pixels + line * surface->pitch32, src);
+    else
+      CPUConvertLine16(surface->pixels16 + line * surface->pitchinpix, src);
+  } else if(surface->format.bpp == 32) {
+    const uint32* cm = systemColorMap->v32;
+    uint32 *dest = surface->pixels + line * surface->pitch32;
+
+    for(int x = 120; x; x--)
+    {
+      *dest = cm[*src & 0xFFFF];
+      dest++;
+      src++;
+      *dest = cm[*src & 0xFFFF];
+      dest++;
+      src++;
+    }
+  } else {
+    const uint16* cm = systemColorMap->v16;
+    uint16* dest = surface->pixels16 + line * surface->pitchinpix;
+
+    for(int x = 0; x < 240; x += 2)
+    {
+      dest[x + 0] = cm[(uint16)src[x + 0]];
+      dest[x + 1] = cm[(uint16)src[x + 1]];
+    }
+  }
+}
+
+// Steps the LCD to its next HDraw/HBlank state.  The LCD event has just
+// been taken off the queue, so eventRemaining() still measures from the
+// time it was due at.
+static void CPUUpdateLCD(MDFN_Surface* surface)
+{
+  if(DISPSTAT & 1) { // V-BLANK
+    // if in V-Blank mode, keep computing...
+    if(DISPSTAT & 2) {
+      eventSchedule(EVENT_LCD, eventRemaining(EVENT_LCD) + 1008);
+      VCOUNT++;
+      UPDATE_REG(0x06, VCOUNT);
+      DISPSTAT &= 0xFFFD;
+      UPDATE_REG(0x04, DISPSTAT);
+      CPUCompareVCOUNT();
+    } else {
+      eventSchedule(EVENT_LCD, eventRemaining(EVENT_LCD) + 224);
+      DISPSTAT |= 2;
+      UPDATE_REG(0x04, DISPSTAT);
+      if(DISPSTAT & 16) {
+        IF |= 2;
+        UPDATE_REG(0x202, IF);
+      }
+    }
+
+    if(VCOUNT >= 228) { //Reaching last line
+      cpuLastFrameDirty = cpuFrameDirty;
+      cpuFrameDirty = false;
+      cpuLinesSkipped = 0;
+      DISPSTAT &= 0xFFFC;
+      UPDATE_REG(0x04, DISPSTAT);
+      VCOUNT = 0;
+      UPDATE_REG(0x06, VCOUNT);
+      CPUCompareVCOUNT();
+    }
+  } else {
+    if(DISPSTAT & 2) {
+      // if in H-Blank, leave it and move to drawing mode
+      VCOUNT++;
+      UPDATE_REG(0x06, VCOUNT);
+
+      eventSchedule(EVENT_LCD, eventRemaining(EVENT_LCD) + 1008);
+      DISPSTAT &= 0xFFFD;
+      if(VCOUNT == 160) {
+        //ticks = 0;
+        //puts("VBlank");
+        uint32 joy = padbufblah;
+        P1 = 0x03FF ^ (joy & 0x3FF);
+        //if(cpuEEPROMSensorEnabled)
+          //systemUpdateMotionSensor();
+        UPDATE_REG(0x130, P1);
+        uint16 P1CNT = READ16LE(((uint16 *)&ioMem[0x132]));
+        // this seems wrong, but there are cases where the game
+        // can enter the stop state without requesting an IRQ from
+        // the joypad.
+        if((P1CNT & 0x4000) || stopState) {
+          uint16 p1 = (0x3FF ^ P1) & 0x3FF;
+          if(P1CNT & 0x8000) {
+            if(p1 == (P1CNT & 0x3FF)) {
+              IF |= 0x1000;
+              UPDATE_REG(0x202, IF);
+            }
+          } else {
+            if(p1 & P1CNT) {
+              IF |= 0x1000;
+              UPDATE_REG(0x202, IF);
+            }
+          }
+        }
+
+        DISPSTAT |= 1;
+        DISPSTAT &= 0xFFFD;
+        UPDATE_REG(0x04, DISPSTAT);
+        if(DISPSTAT & 0x0008) {
+          IF |= 1;
+          UPDATE_REG(0x202, IF);
+        }
+        CPUCheckDMA(1, 0x0f);
+      }
+
+      UPDATE_REG(0x04, DISPSTAT);
+      CPUCompareVCOUNT();
+
+    } else {
+      if(HelloSkipper)
+        cpuFrameDirty = true;
+      else if(!cpuFrameDirty && !cpuLastFrameDirty)
+        cpuLinesSkipped++;
+#ifdef HAVE_RENDER_THREAD
+      else if(cpuRenderThreadOn)
+        CPURenderQueue(surface, VCOUNT);
+#endif
+      else
+        CPUDrawLine(surface, VCOUNT);
+      // entering H-Blank
+      DISPSTAT |= 2;
+      UPDATE_REG(0x04, DISPSTAT);
+      eventSchedule(EVENT_LCD, eventRemaining(EVENT_LCD) + 224);
+      CPUCheckDMA(2, 0x0f);
+      if(DISPSTAT & 16) {
+        IF |= 2;
+        UPDATE_REG(0x202, IF);
+      }
+      if(VCOUNT == 159) {
+        frameready = 1;
+        cpuBreakLoop = 1;
+      }
+    }
+  }
+}
+
 static void CPULoop(EmulateSpecStruct* espec, int ticks)
 {
   MDFN_Surface* surface = espec->surface;
   int clockTicks;
-  int timerOverflow = 0;
   // variable used by the CPU core
   cpuTotalTicks = 0;
   cpuBreakLoop = false;
   cpuNextEvent = CPUUpdateTicks();
   if(cpuNextEvent > ticks)
     cpuNextEvent = ticks;
+  cpuIdleLoopSkip = setting_gba_idle_loop;
+  idleLoopPC = 0xFFFFFFFF;
 
 
   for(;;) {
+    // the interpreters run until the next event, a state switch or a
+    // halt and return the ticks of their last instruction
     if(!holdState && !SWITicks) {
       if(armState) {
         clockTicks = RunARM();
       } else {
         clockTicks = RunTHUMB();
       }
-    } else
+    } else {
+      // nothing runs until the next event, which is the first point an
+      // interrupt can wake a halted CPU; go straight there
       clockTicks = CPUUpdateTicks();
+      if(holdState)
+        cpuHaltTicks += clockTicks;
+    }
 
     cpuTotalTicks += clockTicks;
 
     if(cpuTotalTicks >= cpuNextEvent) {
       int remainingTicks = cpuTotalTicks - cpuNextEvent;
 
+      // events may change what a waiting loop reads
+      idleLoopPC = 0xFFFFFFFF;
+
       if (SWITicks)
       {
         SWITicks-=clockTicks;
@@ -3033,256 +3854,45 @@ static void CPULoop(EmulateSpecStruct* espec, int ticks)
 
 updateLoop:
 
-      if (IRQTicks)
-      {
-        IRQTicks -= clockTicks;
-        if (IRQTicks<0)
-          IRQTicks = 0;
-      }
+      eventClock += clockTicks;
       soundTS += clockTicks;
-      lcdTicks -= clockTicks;
-
-      if(lcdTicks <= 0) {
-        if(DISPSTAT & 1) { // V-BLANK
-          // if in V-Blank mode, keep computing...
-          if(DISPSTAT & 2) {
-            lcdTicks += 1008;
-            VCOUNT++;
-            UPDATE_REG(0x06, VCOUNT);
-            DISPSTAT &= 0xFFFD;
-            UPDATE_REG(0x04, DISPSTAT);
-            CPUCompareVCOUNT();
-          } else {
-            lcdTicks += 224;
-            DISPSTAT |= 2;
-            UPDATE_REG(0x04, DISPSTAT);
-            if(DISPSTAT & 16) {
-              IF |= 2;
-              UPDATE_REG(0x202, IF);
-            }
-          }
 
-          if(VCOUNT >= 228) { //Reaching last line
-            DISPSTAT &= 0xFFFC;
-            UPDATE_REG(0x04, DISPSTAT);
-            VCOUNT = 0;
-            UPDATE_REG(0x06, VCOUNT);
-            CPUCompareVCOUNT();
-          }
-        } else {
-          if(DISPSTAT & 2) {
-            // if in H-Blank, leave it and move to drawing mode
-            VCOUNT++;
-            UPDATE_REG(0x06, VCOUNT);
-
-            lcdTicks += 1008;
-            DISPSTAT &= 0xFFFD;
-            if(VCOUNT == 160) {
-              //ticks = 0;
-              //puts("VBlank");
-              uint32 joy = padbufblah;
-              P1 = 0x03FF ^ (joy & 0x3FF);
-              //if(cpuEEPROMSensorEnabled)
-                //systemUpdateMotionSensor();
-              UPDATE_REG(0x130, P1);
-              uint16 P1CNT = READ16LE(((uint16 *)&ioMem[0x132]));
-              // this seems wrong, but there are cases where the game
-              // can enter the stop state without requesting an IRQ from
-              // the joypad.
-              if((P1CNT & 0x4000) || stopState) {
-                uint16 p1 = (0x3FF ^ P1) & 0x3FF;
-                if(P1CNT & 0x8000) {
-                  if(p1 == (P1CNT & 0x3FF)) {
-                    IF |= 0x1000;
-                    UPDATE_REG(0x202, IF);
-                  }
-                } else {
-                  if(p1 & P1CNT) {
-                    IF |= 0x1000;
-                    UPDATE_REG(0x202, IF);
-                  }
-                }
-              }
-
-              DISPSTAT |= 1;
-              DISPSTAT &= 0xFFFD;
-              UPDATE_REG(0x04, DISPSTAT);
-              if(DISPSTAT & 0x0008) {
-                IF |= 1;
-                UPDATE_REG(0x202, IF);
-              }
-              CPUCheckDMA(1, 0x0f);
-            }
-
-            UPDATE_REG(0x04, DISPSTAT);
-            CPUCompareVCOUNT();
-
-          } else {
-            if(!HelloSkipper) {
-              //printf("RL: %d\n", VCOUNT);
-              const uint32 *src = lineMix;
-
-              (*renderLine)();
-
-              if(surface->format.bpp == 32) {
-                const uint32* cm = systemColorMap->v32;
-                uint32 *dest = surface->pixels + VCOUNT * surface->pitch32;
-
-                for(int x = 120; x; x--)
-                {
-                  *dest = cm[*src & 0xFFFF];
-                  dest++;
-                  src++;
-                  *dest = cm[*src & 0xFFFF];
-                  dest++;
-                  src++;
-                }
-              } else {
-                const uint16* cm = systemColorMap->v16;
-                uint16* dest = surface->pixels16 + VCOUNT * surface->pitchinpix;
-
-                for(int x = 0; x < 240; x += 2)
-                {
-                  dest[x + 0] = cm[(uint16)src[x + 0]];
-                  dest[x + 1] = cm[(uint16)src[x + 1]];
-                }
-              }
-            }
-            // entering H-Blank
-            DISPSTAT |= 2;
-            UPDATE_REG(0x04, DISPSTAT);
-            lcdTicks += 224;
-            CPUCheckDMA(2, 0x0f);
-            if(DISPSTAT & 16) {
-              IF |= 2;
-              UPDATE_REG(0x202, IF);
-            }
-            if(VCOUNT == 159) {
-              frameready = 1;
-              cpuBreakLoop = 1;
-            }
-          }
+      // timers don't count in stop mode
+      if(stopState) {
+        for(int i = EVENT_TIMER0; i <= EVENT_TIMER3; i++) {
+          if(eventPending(i))
+            eventSchedule(i, eventRemaining(i) + clockTicks);
         }
       }
 
-      if(!stopState) {
-        if(timers[0].On) {
-          timers[0].Ticks -= clockTicks;
-          if(timers[0].Ticks <= 0) {
-            timers[0].Ticks += (0x10000 - timers[0].Reload) << timers[0].ClockReload;
-            timerOverflow |= 1;
-            soundTimerOverflow(0);
-            if(timers[0].CNT & 0x40) {
-              IF |= 0x08;
-              UPDATE_REG(0x202, IF);
-            }
-          }
-          timers[0].D = 0xFFFF - (timers[0].Ticks >> timers[0].ClockReload);
-          UPDATE_REG(0x100, timers[0].D);
-        }
-
-        if(timers[1].On) {
-          if(timers[1].CNT & 4) {
-            if(timerOverflow & 1) {
-              timers[1].D++;
-              if(timers[1].D == 0) {
-                timers[1].D += timers[1].Reload;
-                timerOverflow |= 2;
-                soundTimerOverflow(1);
-                if(timers[1].CNT & 0x40) {
-                  IF |= 0x10;
-                  UPDATE_REG(0x202, IF);
-                }
-              }
-              UPDATE_REG(0x104, timers[1].D);
-            }
-          } else {
-            timers[1].Ticks -= clockTicks;
-            if(timers[1].Ticks <= 0) {
-              timers[1].Ticks += (0x10000 - timers[1].Reload) << timers[1].ClockReload;
-              timerOverflow |= 2;
-              soundTimerOverflow(1);
-              if(timers[1].CNT & 0x40) {
-                IF |= 0x10;
-                UPDATE_REG(0x202, IF);
-              }
-            }
-            timers[1].D = 0xFFFF - (timers[1].Ticks >> timers[1].ClockReload);
-            UPDATE_REG(0x104, timers[1].D);
-          }
-        }
-
-        if(timers[2].On) {
-          if(timers[2].CNT & 4) {
-            if(timerOverflow & 2) {
-              timers[2].D++;
-              if(timers[2].D == 0) {
-                timers[2].D += timers[2].Reload;
-                timerOverflow |= 4;
-                if(timers[2].CNT & 0x40) {
-                  IF |= 0x20;
-                  UPDATE_REG(0x202, IF);
-                }
-              }
-              UPDATE_REG(0x108, timers[2].D);
-            }
-          } else {
-            timers[2].Ticks -= clockTicks;
-            if(timers[2].Ticks <= 0) {
-              timers[2].Ticks += (0x10000 - timers[2].Reload) << timers[2].ClockReload;
-              timerOverflow |= 4;
-              if(timers[2].CNT & 0x40) {
-                IF |= 0x20;
-                UPDATE_REG(0x202, IF);
-              }
-            }
-            timers[2].D = 0xFFFF - (timers[2].Ticks >> timers[2].ClockReload);
-            UPDATE_REG(0x108, timers[2].D);
-          }
-        }
-
-        if(timers[3].On) {
-          if(timers[3].CNT & 4) {
-            if(timerOverflow & 4) {
-              timers[3].D++;
-              if(timers[3].D == 0) {
-                timers[3].D += timers[3].Reload;
-                if(timers[3].CNT & 0x40) {
-                  IF |= 0x40;
-                  UPDATE_REG(0x202, IF);
-                }
-              }
-              UPDATE_REG(0x10C, timers[3].D);
-            }
-          } else {
-              timers[3].Ticks -= clockTicks;
-            if(timers[3].Ticks <= 0) {
-              timers[3].Ticks += (0x10000 - timers[3].Reload) << timers[3].ClockReload;
-              if(timers[3].CNT & 0x40) {
-                IF |= 0x40;
-                UPDATE_REG(0x202, IF);
-              }
-            }
-            timers[3].D = 0xFFFF - (timers[3].Ticks >> timers[3].ClockReload);
-            UPDATE_REG(0x10C, timers[3].D);
-          }
+      for(int id; (id = eventNextDue()) >= 0; ) {
+        switch(id) {
+        case EVENT_IRQ:
+          break;
+        case EVENT_LCD:
+          CPUUpdateLCD(surface);
+          break;
+        case EVENT_DMA:
+          break;
+        default:
+          CPUTimerEvent(id - EVENT_TIMER0);
+          break;
         }
       }
 
-      timerOverflow = 0;
-
       ticks -= clockTicks;
 
+      // the DMA transfers started since the last boundary stall the CPU
+      // after the ones already pending
+      if(cpuDmaTicksToUpdate > 0) {
+        eventSchedule(EVENT_DMA, (eventPending(EVENT_DMA) ? eventRemaining(EVENT_DMA) : 0) + cpuDmaTicksToUpdate);
+        cpuDmaTicksToUpdate = 0;
+      }
+
       cpuNextEvent = CPUUpdateTicks();
 
-      if(cpuDmaTicksToUpdate > 0) {
-        if(cpuDmaTicksToUpdate > cpuNextEvent)
-          clockTicks = cpuNextEvent;
-        else
-          clockTicks = cpuDmaTicksToUpdate;
-        cpuDmaTicksToUpdate -= clockTicks;
-        if(cpuDmaTicksToUpdate < 0)
-          cpuDmaTicksToUpdate = 0;
+      if(eventPending(EVENT_DMA)) {
+        clockTicks = cpuNextEvent;
         cpuDmaHack = true;
         goto updateLoop;
       }
@@ -3294,7 +3904,7 @@ updateLoop:
         if(res) {
           if (intState)
           {
-            if (!IRQTicks)
+            if (!eventPending(EVENT_IRQ))
             {
               CPUInterrupt();
               intState = false;
@@ -3308,9 +3918,9 @@ updateLoop:
             if (!holdState)
             {
               intState = true;
-              IRQTicks=7;
-              if (cpuNextEvent> IRQTicks)
-                cpuNextEvent = IRQTicks;
+              eventSchedule(EVENT_IRQ, 7);
+              if (cpuNextEvent > 7)
+                cpuNextEvent = 7;
             }
             else
             {
@@ -3352,6 +3962,14 @@ updateLoop:
   }
 }
 
+bool FrameUnderway(void)
+{
+ // lines of the frame done, the one in H-Blank included
+ const int lines = VCOUNT + ((DISPSTAT & 2) ? 1 : 0);
+
+ return VCOUNT < 160 && lines > 0 && lines < 160;
+}
+
 void Emulate(EmulateSpecStruct *espec)
 {
  espec->DisplayRect.x = 0;
@@ -3416,12 +4034,27 @@ void Emulate(EmulateSpecStruct *espec)
  frameready = 0;
 
  HelloSkipper = espec->skip;
+ cpuSurface = espec->surface;
+
+#ifdef HAVE_RENDER_THREAD
+ if(cpuRenderThreadOn != (setting_gba_threaded_render != 0))
+ {
+  if(cpuRenderThreadOn)
+   CPURenderThreadStop();
+  else
+   CPURenderThreadStart();
+ }
+#endif
 
  MDFNMP_ApplyPeriodicCheats();
 
  while(!frameready && (soundTS < 300000))
   CPULoop(espec, 300000);
 
+ CPU_RENDER_SYNC();
+
+ espec->FrameUnchanged = frameready && cpuLinesSkipped == 160;
+
  if(GBA_RTC)
   GBA_RTC->AddTime(soundTS);
 
@@ -3431,13 +4064,13 @@ void Emulate(EmulateSpecStruct *espec)
 }
 static void SetLayerEnableMask(uint64 mask)
 {
+ CPURedrawFrame();
+
  layerSettings = mask << 8;
  layerEnable = layerSettings & DISPCNT;
 
  CPUUpdateRender();
  CPUUpdateRenderBuffers(true);
- CPUUpdateWindow0();
- CPUUpdateWindow1();
 }
 
 void DoSimpleCommand(int cmd)
@@ -61,6 +61,23 @@ typedef union {
 extern memoryMap map[256];
 #endif
 
+// Page tables of CPURead*()/CPUWrite*() over the 28-bit bus.  Accesses to a
+// page with a NULL address go through the full handler, the others use
+// address[addr & mask] directly.
+#define MEMORY_PAGE_SHIFT 14
+#define MEMORY_PAGES (0x10000000 >> MEMORY_PAGE_SHIFT)
+
+extern memoryMap memoryReadPages[MEMORY_PAGES];
+extern memoryMap memoryWritePages[MEMORY_PAGES];
+
+// Number of bytes, at most max, from address on that one of the page tables
+// maps to contiguous host memory starting at *host.
+uint32 CPUHostSpan(const memoryMap *pages, uint32 address, uint32 max, uint8 **host);
+
+// Bookkeeping the write handlers do, for len bytes at address written
+// straight to the host memory of memoryWritePages.
+void CPUHostWritten(uint32 address, uint32 len);
+
 extern bool busPrefetch;
 extern bool busPrefetchEnable;
 extern uint32 busPrefetchCount;
@@ -79,6 +96,55 @@ extern uint32 N_FLAG;
 extern bool Z_FLAG;
 extern bool C_FLAG;
 extern bool V_FLAG;
+
+// C and V of the last flag-setting addition or subtraction are only worked
+// out from its operands when they are read.  flagLazy says which of C_FLAG
+// and V_FLAG are stale; go through the GET_/SET_ macros for these two.
+#define FLAG_LAZY_C   1
+#define FLAG_LAZY_V   2
+#define FLAG_LAZY_SUB 4
+
+extern uint32 flagLhs;
+extern uint32 flagRhs;
+extern uint32 flagRes;
+extern uint8 flagLazy;
+
+static INLINE bool CPULazyCarry(void)
+{
+  if(flagLazy & FLAG_LAZY_SUB)
+    return ((flagLhs & ~flagRhs) | (flagLhs & ~flagRes) | (~flagRhs & ~flagRes)) >> 31;
+  return ((flagLhs & flagRhs) | (flagLhs & ~flagRes) | (flagRhs & ~flagRes)) >> 31;
+}
+
+static INLINE bool CPULazyOverflow(void)
+{
+  if(flagLazy & FLAG_LAZY_SUB)
+    return ((flagLhs & ~flagRhs & ~flagRes) | (~flagLhs & flagRhs & flagRes)) >> 31;
+  return ((flagLhs & flagRhs & ~flagRes) | (~flagLhs & ~flagRhs & flagRes)) >> 31;
+}
+
+#define GET_C_FLAG() ((flagLazy & FLAG_LAZY_C) ? CPULazyCarry() : C_FLAG)
+#define GET_V_FLAG() ((flagLazy & FLAG_LAZY_V) ? CPULazyOverflow() : V_FLAG)
+
+#define SET_C_FLAG(x) (C_FLAG = (x), flagLazy &= ~FLAG_LAZY_C)
+#define SET_V_FLAG(x) (V_FLAG = (x), flagLazy &= ~FLAG_LAZY_V)
+
+// c = a + b (+ carry), or c = a - b (- borrow)
+#define SET_ADD_FLAGS(a, b, c) \
+  (flagLhs = (a), flagRhs = (b), flagRes = (c), flagLazy = FLAG_LAZY_C | FLAG_LAZY_V)
+#define SET_SUB_FLAGS(a, b, c) \
+  (flagLhs = (a), flagRhs = (b), flagRes = (c), flagLazy = FLAG_LAZY_C | FLAG_LAZY_V | FLAG_LAZY_SUB)
+
+// Stores the pending C and V in C_FLAG and V_FLAG.
+static INLINE void CPUResolveFlags(void)
+{
+  if(flagLazy & FLAG_LAZY_C)
+    C_FLAG = CPULazyCarry();
+  if(flagLazy & FLAG_LAZY_V)
+    V_FLAG = CPULazyOverflow();
+  flagLazy = 0;
+}
+
 extern bool armIrqEnable;
 extern bool armState;
 extern int armMode;
@@ -107,6 +173,13 @@ extern void CPUUpdateFlags();
 extern uint8 cpuBitsSet[256];
 extern uint8 cpuLowestBitSet[256];
 
+// Cycles the CPU spent halted, which CPULoop() jumps over event to event,
+// and the timer overflows folded into a later one meanwhile instead of
+// being serviced as events.  Totals since the game was loaded, for
+// debugging.
+extern uint64 cpuHaltTicks;
+extern uint64 cpuHaltOverflows;
+
 extern struct EmulatedSystem GBASystem;
 
 int32 MDFNGBA_GetTimerPeriod(int which);
@@ -148,6 +221,11 @@ void DoSimpleCommand(int cmd);
 void SetInput(unsigned port, const char *type, void *ptr);
 void Emulate(EmulateSpecStruct *espec);
 
+// True between Emulate() calls when a frame has been partly drawn, as after
+// a reset or a call that returned before its last line.  The rest of it must go to
+// the same surface.
+bool FrameUnderway(void);
+
 extern MDFNGI EmulatedGBA;
 extern bool use_mednafen_save_method;
 
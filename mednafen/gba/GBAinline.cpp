@@ -21,12 +21,25 @@
 #include "Port.h"
 #include "RTC.h"
 #include "GBAinline.h"
+#include "event.h"
+
+// The counters of running timers are not kept in ioMem; they are derived
+// from the time left to the scheduled overflow when read.
+static INLINE uint16 CPUTimerCount(int n)
+{
+  return 0xFFFF - (CPUTimerTicksLeft(n, eventRemaining(EVENT_TIMER0 + n) - cpuTotalTicks) >> timers[n].ClockReload);
+}
 
 uint32 CPUReadMemory(uint32 address)
 {  
   uint32 value;
 
-  switch(address >> 24) 
+  if(address < 0x10000000 && memoryReadPages[address >> MEMORY_PAGE_SHIFT].address)
+  {
+    const memoryMap &page = memoryReadPages[address >> MEMORY_PAGE_SHIFT];
+    value = READ32LE(((uint32 *)&page.address[address & page.mask & ~3]));
+  }
+  else switch(address >> 24) 
   {
    case 0:
     if(reg[15].I >> 24) 
@@ -52,6 +65,13 @@ uint32 CPUReadMemory(uint32 address)
         value = READ32LE(((uint32 *)&ioMem[address & 0x3fC]));
       else
         value = READ16LE(((uint16 *)&ioMem[address & 0x3fc]));
+      if (((address & 0x3fc)>0xFF) && ((address & 0x3fc)<0x110))
+      {
+        int n = (address >> 2) & 3;
+        cpuIdleLoopActivity++;
+        if (eventPending(EVENT_TIMER0 + n))
+          value = (value & 0xFFFF0000) | CPUTimerCount(n);
+      }
     } else goto unreadable;
     break;
   case 5:
@@ -79,11 +99,13 @@ uint32 CPUReadMemory(uint32 address)
     value = READ32LE(((uint32 *)&rom[address&0x1FFFFFC]));
     break;    
   case 13:
+    cpuIdleLoopActivity++;
     if(cpuEEPROMEnabled)
       // no need to swap this
       return eepromRead(address);
     goto unreadable;
   case 14:
+    cpuIdleLoopActivity++;
     if(cpuFlashEnabled | cpuSramEnabled)
       // no need to swap this
       return flashRead(address);
@@ -114,7 +136,12 @@ uint32 CPUReadHalfWord(uint32 address)
 {
   uint32 value;
   
-  switch(address >> 24) {
+  if(address < 0x10000000 && memoryReadPages[address >> MEMORY_PAGE_SHIFT].address)
+  {
+    const memoryMap &page = memoryReadPages[address >> MEMORY_PAGE_SHIFT];
+    value = READ16LE(((uint16 *)&page.address[address & page.mask & ~1]));
+  }
+  else switch(address >> 24) {
   case 0:
     if (reg[15].I >> 24) {
       if(address < 0x4000) {
@@ -135,17 +162,10 @@ uint32 CPUReadHalfWord(uint32 address)
       value =  READ16LE(((uint16 *)&ioMem[address & 0x3fe]));
       if (((address & 0x3fe)>0xFF) && ((address & 0x3fe)<0x10E))
       {
-        if (((address & 0x3fe) == 0x100) && timers[0].On)
-          value = 0xFFFF - ((timers[0].Ticks-cpuTotalTicks) >> timers[0].ClockReload);
-        else
-        if (((address & 0x3fe) == 0x104) && timers[1].On && !(timers[1].CNT & 4))
-          value = 0xFFFF - ((timers[1].Ticks-cpuTotalTicks) >> timers[1].ClockReload);
-        else
-        if (((address & 0x3fe) == 0x108) && timers[2].On && !(timers[2].CNT & 4))
-          value = 0xFFFF - ((timers[2].Ticks-cpuTotalTicks) >> timers[2].ClockReload);
-        else
-        if (((address & 0x3fe) == 0x10C) && timers[3].On && !(timers[3].CNT & 4))
-          value = 0xFFFF - ((timers[3].Ticks-cpuTotalTicks) >> timers[3].ClockReload);
+        int n = (address >> 2) & 3;
+        cpuIdleLoopActivity++;
+        if (!(address & 2) && eventPending(EVENT_TIMER0 + n))
+          value = CPUTimerCount(n);
       }
     }
     else goto unreadable;
@@ -173,16 +193,21 @@ uint32 CPUReadHalfWord(uint32 address)
   case 11:
   case 12:
     if(GBA_RTC && (address == 0x80000c4 || address == 0x80000c6 || address == 0x80000c8))
+    {
+     cpuIdleLoopActivity++;
      value = GBA_RTC->Read(address);
+    }
     else
       value = READ16LE(((uint16 *)&rom[address & 0x1FFFFFE]));
     break;    
   case 13:
+    cpuIdleLoopActivity++;
     if(cpuEEPROMEnabled)
       // no need to swap this
       return  eepromRead(address);
     goto unreadable;
   case 14:
+    cpuIdleLoopActivity++;
     if(cpuFlashEnabled | cpuSramEnabled)
       // no need to swap this
       return flashRead(address);
@@ -210,6 +235,12 @@ uint32 CPUReadHalfWord(uint32 address)
 
 uint8 CPUReadByte(uint32 address)
 {
+  if(address < 0x10000000 && memoryReadPages[address >> MEMORY_PAGE_SHIFT].address)
+  {
+    const memoryMap &page = memoryReadPages[address >> MEMORY_PAGE_SHIFT];
+    return page.address[address & page.mask];
+  }
+
   switch(address >> 24) {
   case 0:
     if (reg[15].I >> 24) {
@@ -224,7 +255,16 @@ uint8 CPUReadByte(uint32 address)
     return internalRAM[address & 0x7fff];
   case 4:
     if((address < 0x4000400) && ioReadable[address & 0x3ff])
+    {
+      if (((address & 0x3fe)>0xFF) && ((address & 0x3fe)<0x10E))
+      {
+        int n = (address >> 2) & 3;
+        cpuIdleLoopActivity++;
+        if (!(address & 2) && eventPending(EVENT_TIMER0 + n))
+          return CPUTimerCount(n) >> ((address & 1) << 3);
+      }
       return ioMem[address & 0x3ff];
+    }
     else goto unreadable;
   case 5:
     return paletteRAM[address & 0x3ff];
@@ -244,10 +284,12 @@ uint8 CPUReadByte(uint32 address)
   case 12:
     return rom[address & 0x1FFFFFF];        
   case 13:
+    cpuIdleLoopActivity++;
     if(cpuEEPROMEnabled)
       return eepromRead(address);
     goto unreadable;
   case 14:
+    cpuIdleLoopActivity++;
     if(cpuSramEnabled | cpuFlashEnabled)
       return flashRead(address);
     if(cpuEEPROMSensorEnabled) {
@@ -41,7 +41,8 @@ typedef struct
 {
         uint16 Value;
         bool On;
-        int32 Ticks;
+        int32 Ticks;    // while not on the event queue, see CPUUpdateTimerEvent()
+        int32 Batch;    // the period while the event is past the next overflow
         int32 Reload;
         int32 ClockReload;
 	uint16 D;
@@ -50,7 +51,46 @@ typedef struct
 
 extern GBATimer timers[4];
 
+// Ticks to the next overflow of a running timer whose event is left ticks
+// away; see CPUTimerEvent() for overflows batched during a halt.
+static INLINE int32 CPUTimerTicksLeft(int n, int32 left)
+{
+  return timers[n].Batch ? (left - 1) % timers[n].Batch + 1 : left;
+}
+
 extern int cpuTotalTicks;
+extern int cpuNextEvent;
+extern int SWITicks;
+extern bool cpuBreakLoop;
+extern bool cpuIdleLoopSkip;
+extern uint32 cpuIdleLoopActivity;
+
+bool CPUIdleLoop(void);
+
+// Longest distance of a backward jump that can close a busy-wait loop.
+#define IDLE_LOOP_SIZE 64
+
+// Ends one step of RunARM()/RunTHUMB(), started at pc.  Returns true when
+// control has to go back to CPULoop(): the next event is due, the CPU left
+// the instruction set of the caller, a HLE SWI is being timed or
+// cpuBreakLoop was set.  Otherwise the ticks are charged here and the
+// caller goes on with the next step.  A step that closed an idle loop is
+// stretched up to the next event.
+static INLINE bool CPUEndStep(uint32 pc, unsigned int &ticks, bool thumb)
+{
+  if(cpuIdleLoopSkip && armNextPC <= pc && pc - armNextPC <= IDLE_LOOP_SIZE && CPUIdleLoop())
+  {
+    if((int)ticks < cpuNextEvent - cpuTotalTicks)
+      ticks = cpuNextEvent - cpuTotalTicks;
+    return true;
+  }
+
+  if(cpuTotalTicks + (int)ticks >= cpuNextEvent || armState == thumb || SWITicks || cpuBreakLoop)
+    return true;
+
+  cpuTotalTicks += ticks;
+  return false;
+}
 
 #define ARM_PREFETCH \
   {\
@@ -47,6 +47,8 @@ MDFN_ALIGN(16) uint32 lineMix[512];
 bool gfxInWin0[512];
 bool gfxInWin1[512];
 
+gfxLineRegs gfxRegs;
+
 int gfxBG2Changed = 0;
 int gfxBG3Changed = 0;
 
@@ -59,18 +61,103 @@ int gfxBG3Y = 0;
 int gfxBG3LastX = 0;
 int gfxBG3LastY = 0;
 int gfxLastVCOUNT = 0;
+uint16 gfxVCOUNT = 0;
 
-#ifdef TILED_RENDERING
-union u8h
+uint32 gfxTileDirty[0x18000 >> 10];
+uint8 gfxTileCache[0x18000 * 2];
+
+uint32 gfxPalette16[256];
+uint32 gfxPalette256[256];
+uint32 gfxPaletteDirty = 0xFFFF;
+
+// Decodes the dirty tiles in [start, end) of VRAM.
+void gfxTileCacheUpdate(uint32 start, uint32 end)
 {
-  struct
-  {
-    /* 0*/  unsigned char lo:4;
-    /* 4*/  unsigned char hi:4;
-  } __attribute__ ((packed));
-  uint8 val;
+  for(uint32 i = start >> 10; i < (end >> 10); i++) {
+    uint32 dirty = gfxTileDirty[i];
+
+    gfxTileDirty[i] = 0;
+    for(uint32 offset = i << 10; dirty; dirty >>= 1, offset += 32) {
+      if(!(dirty & 1))
+        continue;
+
+      const uint8 *src = &vram[offset];
+      uint8 *dest = &gfxTileCache[offset * 2];
+
+      for(int b = 0; b < 32; b++) {
+        dest[b * 2] = src[b] & 0x0F;
+        dest[b * 2 + 1] = src[b] >> 4;
+      }
+    }
+  }
+}
+
+void gfxTileCacheInvalidate(void)
+{
+  memset(gfxTileDirty, 0xFF, sizeof(gfxTileDirty));
+}
+
+// Builds the entries of the banks written since the last call.
+void gfxPaletteRebuild(void)
+{
+  const uint16 *palette = (uint16 *)paletteRAM;
+  uint32 dirty = gfxPaletteDirty;
+
+  gfxPaletteDirty = 0;
+  for(int bank = 0; dirty; dirty >>= 1, bank += 16) {
+    if(!(dirty & 1))
+      continue;
+
+    for(int i = bank; i < bank + 16; i++)
+      gfxPalette16[i] = gfxPalette256[i] = READ16LE(&palette[i]);
+    gfxPalette16[bank] = 0x80000000;
+  }
+  gfxPalette256[0] = 0x80000000;
+}
+
+// Width and height of the OBJ shapes and sizes, by shape << 2 | size.
+static const uint8 gfxSpriteSizes[12][2] = {
+  {  8,  8 }, { 16, 16 }, { 32, 32 }, { 64, 64 },
+  { 16,  8 }, { 32,  8 }, { 32, 16 }, { 64, 32 },
+  {  8, 16 }, {  8, 32 }, { 16, 32 }, { 32, 64 }
 };
 
+// The OAM entries whose rows cover each line, in OAM order.  Hidden
+// sprites and the invalid shape are left out.
+bool gfxSpriteListsDirty = true;
+static uint8 gfxSpriteLines[160][128];
+static uint8 gfxSpriteLineCount[160];
+
+static void gfxSpriteListsUpdate(void)
+{
+  if(!gfxSpriteListsDirty)
+    return;
+  gfxSpriteListsDirty = false;
+
+  memset(gfxSpriteLineCount, 0, sizeof(gfxSpriteLineCount));
+  for(int i = 0; i < 128; i++) {
+    const uint16 a0 = READ16LE(&((uint16 *)oam)[i << 2]);
+    const uint16 a1 = READ16LE(&((uint16 *)oam)[(i << 2) + 1]);
+    const int shape = ((a0 >> 12) & 0x0c) | (a1 >> 14);
+
+    if(shape >= 12 || (a0 & 0x0300) == 0x0200)
+      continue;
+
+    int sy = (a0 & 255);
+    if(sy > 160)
+      sy -= 256;
+
+    // double size affine sprites cover twice their height
+    int end = sy + (gfxSpriteSizes[shape][1] << ((a0 & 0x0300) == 0x0300));
+    if(end > 160)
+      end = 160;
+
+    for(int y = sy < 0 ? 0 : sy; y < end; y++)
+      gfxSpriteLines[y][gfxSpriteLineCount[y]++] = i;
+  }
+}
+
+#ifdef TILED_RENDERING
 union TileEntry
 {
   struct
@@ -88,14 +175,14 @@ struct TileLine
   uint32 pixels[8];
 };
 
-typedef const TileLine (*TileReader) (const uint16 *, const int, const uint8 *, uint16 *, const uint32);
+typedef const TileLine (*TileReader) (const uint16 *, const int, const uint8 *, const uint32 *, const uint32);
 
-static inline void gfxDrawPixel(uint32 *dest, const uint8 color, const uint16 *palette, const uint32 prio)
+static inline void gfxDrawPixel(uint32 *dest, const uint8 color, const uint32 *palette, const uint32 prio)
 {
-  *dest = color ? (READ16LE(&palette[color]) | prio): 0x80000000;
+  *dest = gfxPalettePixel(palette[color], prio);
 }
 
-inline const TileLine gfxReadTile(const uint16 *screenSource, const int yyy, const uint8 *charBase, uint16 *palette, const uint32 prio)
+inline const TileLine gfxReadTile(const uint16 *screenSource, const int yyy, const uint8 *charBase, const uint32 *palette, const uint32 prio)
 {
   TileEntry tile;
   tile.val = READ16LE(screenSource);
@@ -132,7 +219,7 @@ inline const TileLine gfxReadTile(const uint16 *screenSource, const int yyy, con
   return tileLine;
 }
 
-inline const TileLine gfxReadTilePal(const uint16 *screenSource, const int yyy, const uint8 *charBase, uint16 *palette, const uint32 prio)
+inline const TileLine gfxReadTilePal(const uint16 *screenSource, const int yyy, const uint8 *charBase, const uint32 *palette, const uint32 prio)
 {
   TileEntry tile;
   tile.val = READ16LE(screenSource);
@@ -142,29 +229,29 @@ inline const TileLine gfxReadTilePal(const uint16 *screenSource, const int yyy,
   palette += tile.palette * 16;
   TileLine tileLine;
 
-  const u8h *tileBase = (u8h*) &charBase[tile.tileNum * 32 + tileY * 4];
+  const uint8 *tileBase = &gfxTileCache[(charBase - vram + tile.tileNum * 32 + tileY * 4) * 2];
 
   if (!tile.hFlip)
   {
-    gfxDrawPixel(&tileLine.pixels[0], tileBase[0].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[1], tileBase[0].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[2], tileBase[1].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[3], tileBase[1].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[4], tileBase[2].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[5], tileBase[2].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[6], tileBase[3].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[7], tileBase[3].hi, palette, prio);
+    gfxDrawPixel(&tileLine.pixels[0], tileBase[0], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[1], tileBase[1], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[2], tileBase[2], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[3], tileBase[3], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[4], tileBase[4], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[5], tileBase[5], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[6], tileBase[6], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[7], tileBase[7], palette, prio);
   }
   else
   {
-    gfxDrawPixel(&tileLine.pixels[0], tileBase[3].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[1], tileBase[3].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[2], tileBase[2].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[3], tileBase[2].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[4], tileBase[1].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[5], tileBase[1].lo, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[6], tileBase[0].hi, palette, prio);
-    gfxDrawPixel(&tileLine.pixels[7], tileBase[0].lo, palette, prio);
+    gfxDrawPixel(&tileLine.pixels[0], tileBase[7], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[1], tileBase[6], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[2], tileBase[5], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[3], tileBase[4], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[4], tileBase[3], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[5], tileBase[2], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[6], tileBase[1], palette, prio);
+    gfxDrawPixel(&tileLine.pixels[7], tileBase[0], palette, prio);
   }
 
   return tileLine;
@@ -182,9 +269,8 @@ static inline void gfxDrawTileClipped(const TileLine &tileLine, uint32 *line, co
 
 template<TileReader readTile>
 static void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
-                       uint32 *line)
+                       const uint32 *palette, uint32 *line)
 {
-  uint16 *palette = (uint16 *)paletteRAM;
   uint8 *charBase = &vram[((control >> 2) & 0x03) * 0x4000];
   uint16 *screenBase = (uint16 *)&vram[((control >> 8) & 0x1f) * 0x800];
   uint32 prio = ((control & 3)<<25) + 0x1000000;
@@ -212,15 +298,15 @@ static void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
   bool mosaicOn = (control & 0x40) ? true : false;
 
   int xxx = hofs & maskX;
-  int yyy = (vofs + VCOUNT) & maskY;
-  int mosaicX = (MOSAIC & 0x000F)+1;
-  int mosaicY = ((MOSAIC & 0x00F0)>>4)+1;
+  int yyy = (vofs + gfxVCOUNT) & maskY;
+  int mosaicX = (gfxRegs.MOSAIC & 0x000F)+1;
+  int mosaicY = ((gfxRegs.MOSAIC & 0x00F0)>>4)+1;
 
   if (mosaicOn)
   {
-    if ((VCOUNT % mosaicY) != 0)
+    if ((gfxVCOUNT % mosaicY) != 0)
     {
-      mosaicY = VCOUNT - (VCOUNT % mosaicY);
+      mosaicY = gfxVCOUNT - (gfxVCOUNT % mosaicY);
       yyy = (vofs + mosaicY) & maskY;
     }
   }
@@ -304,17 +390,25 @@ static void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
 
 void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs, uint32 *line)
 {
+  gfxPaletteUpdate();
+
   if (control & 0x80) // 1 pal / 256 col
-    gfxDrawTextScreen<gfxReadTile>(control, hofs, vofs, line);
+    gfxDrawTextScreen<gfxReadTile>(control, hofs, vofs, gfxPalette256, line);
   else // 16 pal / 16 col
-    gfxDrawTextScreen<gfxReadTilePal>(control, hofs, vofs, line);
+  {
+    const uint32 charOffset = ((control >> 2) & 0x03) * 0x4000;
+
+    gfxTileCacheUpdate(charOffset, charOffset + 0x8000);
+    gfxDrawTextScreen<gfxReadTilePal>(control, hofs, vofs, gfxPalette16, line);
+  }
 }
 
 #else
 void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
                               uint32 *line)
 {
-  uint16 *palette = (uint16 *)paletteRAM;
+  gfxPaletteUpdate();
+
   uint8 *charBase = &vram[((control >> 2) & 0x03) * 0x4000];
   uint16 *screenBase = (uint16 *)&vram[((control >> 8) & 0x1f) * 0x800];
   uint32 prio = ((control & 3)<<25) + 0x1000000;
@@ -341,13 +435,13 @@ void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
   bool mosaicOn = (control & 0x40) ? true : false;
 
   int xxx = hofs & maskX;
-  int yyy = (vofs + VCOUNT) & maskY;
-  int mosaicX = (MOSAIC & 0x000F)+1;
-  int mosaicY = ((MOSAIC & 0x00F0)>>4)+1;
+  int yyy = (vofs + gfxVCOUNT) & maskY;
+  int mosaicX = (gfxRegs.MOSAIC & 0x000F)+1;
+  int mosaicY = ((gfxRegs.MOSAIC & 0x00F0)>>4)+1;
 
   if(mosaicOn) {
-    if((VCOUNT % mosaicY) != 0) {
-      mosaicY = (VCOUNT / mosaicY) * mosaicY;
+    if((gfxVCOUNT % mosaicY) != 0) {
+      mosaicY = (gfxVCOUNT / mosaicY) * mosaicY;
       yyy = (vofs + mosaicY) & maskY;
     }
   }
@@ -377,7 +471,7 @@ void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
       
       uint8 color = charBase[tile * 64 + tileY * 8 + tileX];
       
-      line[x] = color ? (READ16LE(&palette[color]) | prio): 0x80000000;
+      line[x] = gfxPalettePixel(gfxPalette256[color], prio);
       
       if(data & 0x0400) {
         if(tileX == 0)
@@ -424,7 +518,7 @@ void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
         color &= 0x0F;
       }
       
-      line[x] = color ? (READ16LE(&palette[pal + color])|prio): 0x80000000;
+      line[x] = gfxPalettePixel(gfxPalette16[pal + color], prio);
 
       if(tileX == tileXmatch)
       {
@@ -481,6 +575,91 @@ void gfxDrawTextScreen(uint16 control, uint16 hofs, uint16 vofs,
 
 #endif
 
+// Lines of a rotation/scaling BG that step one texel right per pixel (PA
+// 0x100, PC 0) read a single row, from xxx on.  gfxRotRowClip gives the
+// pixels [start, end) of the line that fall in a row sizeX wide; row[xxx + x]
+// is in the row for each of them.
+static INLINE void gfxRotRowClip(int xxx, int sizeX, int &start, int &end)
+{
+  start = xxx < 0 ? -xxx : 0;
+  end = sizeX - xxx;
+  if(start > 240)
+    start = 240;
+  if(end > 240)
+    end = 240;
+  if(end < start)
+    end = start;
+}
+
+static void gfxDrawRotRow16(const uint16 *row, int xxx, int sizeX, int prio,
+                            uint32 *line)
+{
+  int start, end;
+  int x = 0;
+
+  gfxRotRowClip(xxx, sizeX, start, end);
+
+  for(; x < start; x++)
+    line[x] = 0x80000000;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i p = _mm_set1_epi32(prio);
+  for(; x + 8 <= end; x += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&row[xxx + x]);
+    _mm_storeu_si128((__m128i *)&line[x], _mm_or_si128(_mm_unpacklo_epi16(v, zero), p));
+    _mm_storeu_si128((__m128i *)&line[x + 4], _mm_or_si128(_mm_unpackhi_epi16(v, zero), p));
+  }
+#endif
+  for(; x < end; x++)
+    line[x] = READ16LE(&row[xxx + x]) | prio;
+  for(; x < 240; x++)
+    line[x] = 0x80000000;
+}
+
+static void gfxDrawRotRow256(const uint8 *row, int xxx, int sizeX, int prio,
+                             uint32 *line)
+{
+  int start, end;
+  int x = 0;
+
+  gfxRotRowClip(xxx, sizeX, start, end);
+
+  for(; x < start; x++)
+    line[x] = 0x80000000;
+  for(; x < end; x++) {
+    uint8 color = row[xxx + x];
+    line[x] = gfxPalettePixel(gfxPalette256[color], prio);
+  }
+  for(; x < 240; x++)
+    line[x] = 0x80000000;
+}
+
+// Tiled version, for a map sizeX texels wide that wraps when wrap is set.
+static void gfxDrawRotRowTiles(const uint8 *screenBase, const uint8 *charBase,
+                               int xxx, int yyy, int sizeX, bool wrap,
+                               int prio, uint32 *line)
+{
+  const uint8 *map = &screenBase[(yyy>>3)*(sizeX>>3)];
+  const uint8 *tiles = &charBase[(yyy & 7)<<3];
+  int start = 0, end = 240;
+  int x = 0;
+
+  if(!wrap) {
+    gfxRotRowClip(xxx, sizeX, start, end);
+    xxx += start;
+  }
+
+  for(; x < start; x++)
+    line[x] = 0x80000000;
+  for(; x < end; x++) {
+    uint8 color = tiles[(map[xxx>>3]<<6) + (xxx & 7)];
+    line[x] = gfxPalettePixel(gfxPalette256[color], prio);
+    xxx = (xxx + 1) & (sizeX - 1);
+  }
+  for(; x < 240; x++)
+    line[x] = 0x80000000;
+}
+
 void gfxDrawRotScreen(uint16 control, 
                              uint16 x_l, uint16 x_h,
                              uint16 y_l, uint16 y_h,
@@ -490,7 +669,8 @@ void gfxDrawRotScreen(uint16 control,
                              int changed,
                              uint32 *line)
 {
-  uint16 *palette = (uint16 *)paletteRAM;
+  gfxPaletteUpdate();
+
   uint8 *charBase = &vram[((control >> 2) & 0x03) * 0x4000];
   uint8 *screenBase = (uint8 *)&vram[((control >> 8) & 0x1f) * 0x800];
   int prio = ((control & 3) << 25) + 0x1000000;
@@ -524,7 +704,7 @@ void gfxDrawRotScreen(uint16 control,
   if(pd & 0x8000)
     dmy |= 0xFFFF8000;
 
-  if(VCOUNT == 0)
+  if(gfxVCOUNT == 0)
     changed = 3;
 
   if(changed & 1) {
@@ -547,8 +727,8 @@ void gfxDrawRotScreen(uint16 control,
   int realY = currentY;
 
   if(control & 0x40) {
-    int mosaicY = ((MOSAIC & 0xF0)>>4) + 1;
-    int y = (VCOUNT % mosaicY);
+    int mosaicY = ((gfxRegs.MOSAIC & 0xF0)>>4) + 1;
+    int y = (gfxVCOUNT % mosaicY);
     realX -= y*dmx;
     realY -= y*dmy;
   }
@@ -565,7 +745,13 @@ void gfxDrawRotScreen(uint16 control,
       yyy += sizeY;
   }
   
-  if(control & 0x80) {
+  if(dx == 0x100 && dy == 0) {
+    if(yyy < 0 || yyy >= sizeY)
+      gfxClearArray(line);
+    else
+      gfxDrawRotRowTiles(screenBase, charBase, xxx, yyy, sizeX,
+                         (control & 0x2000) != 0, prio, line);
+  } else if(control & 0x80) {
     for(int x = 0; x < 240; x++) {
       if(xxx < 0 ||
          yyy < 0 ||
@@ -580,7 +766,7 @@ void gfxDrawRotScreen(uint16 control,
         
         uint8 color = charBase[(tile<<6) + (tileY<<3) + tileX];
           
-        line[x] = color ? (READ16LE(&palette[color])|prio): 0x80000000;
+        line[x] = gfxPalettePixel(gfxPalette256[color], prio);
       }
       realX += dx;
       realY += dy;
@@ -612,7 +798,7 @@ void gfxDrawRotScreen(uint16 control,
         
         uint8 color = charBase[(tile<<6) + (tileY<<3) + tileX];
           
-        line[x] = color ? (READ16LE(&palette[color])|prio): 0x80000000;
+        line[x] = gfxPalettePixel(gfxPalette256[color], prio);
       }
       realX += dx;
       realY += dy;
@@ -632,7 +818,7 @@ void gfxDrawRotScreen(uint16 control,
   }
 
   if(control & 0x40) {    
-    int mosaicX = (MOSAIC & 0xF) + 1;
+    int mosaicX = (gfxRegs.MOSAIC & 0xF) + 1;
     if(mosaicX > 1) {
       int m = 1;
       for(int i = 0; i < 239; i++) {
@@ -681,7 +867,7 @@ void gfxDrawRotScreen16Bit(uint16 control,
   if(pd & 0x8000)
     dmy |= 0xFFFF8000;
 
-  if(VCOUNT == 0)
+  if(gfxVCOUNT == 0)
     changed = 3;
   
   if(changed & 1) {
@@ -703,8 +889,8 @@ void gfxDrawRotScreen16Bit(uint16 control,
   int realY = currentY;
 
   if(control & 0x40) {
-    int mosaicY = ((MOSAIC & 0xF0)>>4) + 1;
-    int y = (VCOUNT % mosaicY);
+    int mosaicY = ((gfxRegs.MOSAIC & 0xF0)>>4) + 1;
+    int y = (gfxVCOUNT % mosaicY);
     realX -= y*dmx;
     realY -= y*dmy;
   }
@@ -712,24 +898,31 @@ void gfxDrawRotScreen16Bit(uint16 control,
   int xxx = (realX >> 8);
   int yyy = (realY >> 8);
   
-  for(int x = 0; x < 240; x++) {
-    if(xxx < 0 ||
-       yyy < 0 ||
-       xxx >= sizeX ||
-       yyy >= sizeY) {
-      line[x] = 0x80000000;
-    } else {
-      line[x] = (READ16LE(&screenBase[yyy * sizeX + xxx]) | prio);
+  if(dx == 0x100 && dy == 0) {
+    if(yyy < 0 || yyy >= sizeY)
+      gfxClearArray(line);
+    else
+      gfxDrawRotRow16(&screenBase[yyy * sizeX], xxx, sizeX, prio, line);
+  } else {
+    for(int x = 0; x < 240; x++) {
+      if(xxx < 0 ||
+         yyy < 0 ||
+         xxx >= sizeX ||
+         yyy >= sizeY) {
+        line[x] = 0x80000000;
+      } else {
+        line[x] = (READ16LE(&screenBase[yyy * sizeX + xxx]) | prio);
+      }
+      realX += dx;
+      realY += dy;
+      
+      xxx = (realX >> 8);
+      yyy = (realY >> 8);
     }
-    realX += dx;
-    realY += dy;
-    
-    xxx = (realX >> 8);
-    yyy = (realY >> 8);
   }
 
   if(control & 0x40) {    
-    int mosaicX = (MOSAIC & 0xF) + 1;
+    int mosaicX = (gfxRegs.MOSAIC & 0xF) + 1;
     if(mosaicX > 1) {
       int m = 1;
       for(int i = 0; i < 239; i++) {
@@ -753,8 +946,9 @@ void gfxDrawRotScreen256(uint16 control,
                                 int changed,
                                 uint32 *line)
 {
-  uint16 *palette = (uint16 *)paletteRAM;
-  uint8 *screenBase = (DISPCNT & 0x0010) ? &vram[0xA000] : &vram[0x0000];
+  gfxPaletteUpdate();
+
+  uint8 *screenBase = (gfxRegs.DISPCNT & 0x0010) ? &vram[0xA000] : &vram[0x0000];
   int prio = ((control & 3) << 25) + 0x1000000;
   int sizeX = 240;
   int sizeY = 160;
@@ -779,7 +973,7 @@ void gfxDrawRotScreen256(uint16 control,
   if(pd & 0x8000)
     dmy |= 0xFFFF8000;
 
-  if(VCOUNT == 0)
+  if(gfxVCOUNT == 0)
     changed = 3;
 
   if(changed & 1) {
@@ -802,8 +996,8 @@ void gfxDrawRotScreen256(uint16 control,
   int realY = currentY;
 
   if(control & 0x40) {
-    int mosaicY = ((MOSAIC & 0xF0)>>4) + 1;
-    int y = (VCOUNT / mosaicY) * mosaicY;
+    int mosaicY = ((gfxRegs.MOSAIC & 0xF0)>>4) + 1;
+    int y = (gfxVCOUNT / mosaicY) * mosaicY;
     realX = startX + y*dmx;
     realY = startY + y*dmy;
   }
@@ -811,26 +1005,33 @@ void gfxDrawRotScreen256(uint16 control,
   int xxx = (realX >> 8);
   int yyy = (realY >> 8);
   
-  for(int x = 0; x < 240; x++) {
-    if(xxx < 0 ||
-         yyy < 0 ||
-       xxx >= sizeX ||
-       yyy >= sizeY) {
-      line[x] = 0x80000000;
-    } else {
-      uint8 color = screenBase[yyy * 240 + xxx];
+  if(dx == 0x100 && dy == 0) {
+    if(yyy < 0 || yyy >= sizeY)
+      gfxClearArray(line);
+    else
+      gfxDrawRotRow256(&screenBase[yyy * 240], xxx, sizeX, prio, line);
+  } else {
+    for(int x = 0; x < 240; x++) {
+      if(xxx < 0 ||
+           yyy < 0 ||
+         xxx >= sizeX ||
+         yyy >= sizeY) {
+        line[x] = 0x80000000;
+      } else {
+        uint8 color = screenBase[yyy * 240 + xxx];
+        
+        line[x] = gfxPalettePixel(gfxPalette256[color], prio);
+      }
+      realX += dx;
+      realY += dy;
       
-      line[x] = color ? (READ16LE(&palette[color])|prio): 0x80000000;
+      xxx = (realX >> 8);
+      yyy = (realY >> 8);
     }
-    realX += dx;
-    realY += dy;
-    
-    xxx = (realX >> 8);
-    yyy = (realY >> 8);
   }
 
   if(control & 0x40) {    
-    int mosaicX = (MOSAIC & 0xF) + 1;
+    int mosaicX = (gfxRegs.MOSAIC & 0xF) + 1;
     if(mosaicX > 1) {
       int m = 1;
       for(int i = 0; i < 239; i++) {
@@ -854,7 +1055,7 @@ void gfxDrawRotScreen16Bit160(uint16 control,
                                      int changed,
                                      uint32 *line)
 {
-  uint16 *screenBase = (DISPCNT & 0x0010) ? (uint16 *)&vram[0xa000] :
+  uint16 *screenBase = (gfxRegs.DISPCNT & 0x0010) ? (uint16 *)&vram[0xa000] :
     (uint16 *)&vram[0];
   int prio = ((control & 3) << 25) + 0x1000000;
   int sizeX = 160;
@@ -880,7 +1081,7 @@ void gfxDrawRotScreen16Bit160(uint16 control,
   if(pd & 0x8000)
     dmy |= 0xFFFF8000;
 
-  if(VCOUNT == 0)
+  if(gfxVCOUNT == 0)
     changed = 3;
 
   if(changed & 1) {
@@ -903,8 +1104,8 @@ void gfxDrawRotScreen16Bit160(uint16 control,
   int realY = currentY;
 
   if(control & 0x40) {
-    int mosaicY = ((MOSAIC & 0xF0)>>4) + 1;
-    int y = (VCOUNT / mosaicY) * mosaicY;
+    int mosaicY = ((gfxRegs.MOSAIC & 0xF0)>>4) + 1;
+    int y = (gfxVCOUNT / mosaicY) * mosaicY;
     realX = startX + y*dmx;
     realY = startY + y*dmy;
   }
@@ -912,24 +1113,31 @@ void gfxDrawRotScreen16Bit160(uint16 control,
   int xxx = (realX >> 8);
   int yyy = (realY >> 8);
   
-  for(int x = 0; x < 240; x++) {
-    if(xxx < 0 ||
-       yyy < 0 ||
-       xxx >= sizeX ||
-       yyy >= sizeY) {
-      line[x] = 0x80000000;
-    } else {
-      line[x] = (READ16LE(&screenBase[yyy * sizeX + xxx]) | prio);
+  if(dx == 0x100 && dy == 0) {
+    if(yyy < 0 || yyy >= sizeY)
+      gfxClearArray(line);
+    else
+      gfxDrawRotRow16(&screenBase[yyy * sizeX], xxx, sizeX, prio, line);
+  } else {
+    for(int x = 0; x < 240; x++) {
+      if(xxx < 0 ||
+         yyy < 0 ||
+         xxx >= sizeX ||
+         yyy >= sizeY) {
+        line[x] = 0x80000000;
+      } else {
+        line[x] = (READ16LE(&screenBase[yyy * sizeX + xxx]) | prio);
+      }
+      realX += dx;
+      realY += dy;
+      
+      xxx = (realX >> 8);
+      yyy = (realY >> 8);
     }
-    realX += dx;
-    realY += dy;
-    
-    xxx = (realX >> 8);
-    yyy = (realY >> 8);
   }
 
   if(control & 0x40) {    
-    int mosaicX = (MOSAIC & 0xF) + 1;
+    int mosaicX = (gfxRegs.MOSAIC & 0xF) + 1;
     if(mosaicX > 1) {
       int m = 1;
       for(int i = 0; i < 239; i++) {
@@ -948,69 +1156,28 @@ void gfxDrawSprites(void)
 {
   int m=0;
   gfxClearArray(lineOBJ);
-  if(layerEnable & 0x1000) {
-    uint16 *sprites = (uint16 *)oam;
+  if(gfxRegs.layerEnable & 0x1000) {
+    const uint8 *list = gfxSpriteLines[gfxVCOUNT];
     uint16 *spritePalette = &((uint16 *)paletteRAM)[256];
-    int mosaicY = ((MOSAIC & 0xF000)>>12) + 1;
-    int mosaicX = ((MOSAIC & 0xF00)>>8) + 1;    
+    int mosaicY = ((gfxRegs.MOSAIC & 0xF000)>>12) + 1;
+    int mosaicX = ((gfxRegs.MOSAIC & 0xF00)>>8) + 1;    
 
-    for(int i = 0; i < 128 ; i++) {
+    gfxTileCacheUpdate(0x10000, 0x18000);
+    gfxSpriteListsUpdate();
 
+    for(int n = gfxSpriteLineCount[gfxVCOUNT]; n; n--) {
+      const uint16 *sprites = &((uint16 *)oam)[*list++ << 2];
       uint16 a0 = READ16LE(sprites++);
       uint16 a1 = READ16LE(sprites++);
-      uint16 a2 = READ16LE(sprites++);
-      sprites++;
+      uint16 a2 = READ16LE(sprites);
 
       // ignore OBJ-WIN
       if((a0 & 0x0c00) == 0x0800)
          continue;
       
-      int sizeY = 8;
-      int sizeX = 8;
-      
-      switch(((a0 >>12) & 0x0c)|(a1>>14)) {
-      case 0:
-        break;
-      case 1:
-        sizeX = sizeY = 16;
-        break;
-      case 2:
-        sizeX = sizeY = 32;
-        break;
-      case 3:
-        sizeX = sizeY = 64;
-        break;
-      case 4:
-        sizeX = 16;
-        break;
-      case 5:
-        sizeX = 32;
-        break;
-      case 6:
-        sizeX = 32;
-        sizeY = 16;
-        break;
-      case 7:
-        sizeX = 64;
-        sizeY = 32;
-        break;
-      case 8:
-        sizeY = 16;
-        break;
-      case 9:
-        sizeY = 32;
-        break;
-      case 10:
-        sizeX = 16;
-        sizeY = 32;
-        break;
-      case 11:
-        sizeX = 32;
-        sizeY = 64;
-        break;
-      default:
-        continue;
-      }
+      const int shape = ((a0 >> 12) & 0x0c) | (a1 >> 14);
+      const int sizeX = gfxSpriteSizes[shape][0];
+      const int sizeY = gfxSpriteSizes[shape][1];
 
 #ifdef SPRITE_DEBUG
       int maskX = sizeX-1;
@@ -1030,7 +1197,7 @@ void gfxDrawSprites(void)
           fieldY <<= 1;
         }
         
-        int t = VCOUNT - sy;
+        int t = gfxVCOUNT - sy;
         if((t >= 0) && (t < fieldY)) {
           int sx = (a1 & 0x1FF);
           if((sx < 240) || (((sx + fieldX) & 511) < 240)) {
@@ -1063,10 +1230,10 @@ void gfxDrawSprites(void)
             
             if(a0 & 0x2000) {
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               int inc = 32;
-              if(DISPCNT & 0x40)
+              if(gfxRegs.DISPCNT & 0x40)
                 inc = sizeX >> 2;
               else
                 c &= 0x3FE;
@@ -1108,11 +1275,11 @@ void gfxDrawSprites(void)
               }
             } else {
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40)
+              if(gfxRegs.DISPCNT & 0x40)
                 inc = sizeX >> 3;
               int palette = (a2 >> 8) & 0xF0;                 
               for(int x = 0; x < fieldX; x++) {
@@ -1122,13 +1289,9 @@ void gfxDrawSprites(void)
                    yyy < 0 || yyy >= sizeY ||
                    sx >= 240);
                 else {
-                  uint32 color = vram[0x10000 + ((((c + (yyy>>3) * inc)<<5)
+                  uint32 color = gfxTileCache[((0x10000 + ((((c + (yyy>>3) * inc)<<5)
                                                 + ((yyy & 7)<<2) + ((xxx >> 3)<<5) +
-                                               ((xxx & 7)>>1))&0x7FFF)];
-                  if(xxx & 1)
-                    color >>= 4;
-                  else
-                    color &= 0x0F;
+                                               ((xxx & 7)>>1))&0x7FFF)) << 1) | (xxx & 1)];
                   
                   if ((color==0) && (((prio >> 25)&3) < 
                                      ((lineOBJ[sx]>>25)&3))) {
@@ -1160,7 +1323,7 @@ void gfxDrawSprites(void)
           }
         }
       } else {
-        int t = VCOUNT - sy;
+        int t = gfxVCOUNT - sy;
         if((t >= 0) && (t < sizeY)) {
           int sx = (a1 & 0x1FF);
           if(((sx < 240)||(((sx+sizeX)&511)<240)) && !(a0 & 0x0200)) {
@@ -1168,11 +1331,11 @@ void gfxDrawSprites(void)
               if(a1 & 0x2000)
                 t = sizeY - t - 1;
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40) {
+              if(gfxRegs.DISPCNT & 0x40) {
                 inc = sizeX >> 2;
               } else {
                 c &= 0x3FE;
@@ -1243,11 +1406,11 @@ void gfxDrawSprites(void)
               if(a1 & 0x2000)
                 t = sizeY - t - 1;
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40) {
+              if(gfxRegs.DISPCNT & 0x40) {
                 inc = sizeX >> 3;
               }
               int xxx = 0;
@@ -1266,11 +1429,7 @@ void gfxDrawSprites(void)
                 xxx = 7;
                 for(int xx = sizeX - 1; xx >= 0; xx--) {
                   if(sx < 240) {
-                    uint8 color = vram[address];
-                    if(xx & 1) {
-                      color = (color >> 4);
-                    } else
-                      color &= 0x0F;
+                    uint8 color = gfxTileCache[(address << 1) | (xx & 1)];
                     
                     if ((color==0) && (((prio >> 25)&3) < 
                                        ((lineOBJ[sx]>>25)&3))) {
@@ -1306,11 +1465,7 @@ void gfxDrawSprites(void)
               } else {        
                 for(int xx = 0; xx < sizeX; xx++) {
                   if(sx < 240) {
-                    uint8 color = vram[address];
-                    if(xx & 1) {
-                      color = (color >> 4);
-                    } else
-                      color &= 0x0F;
+                    uint8 color = gfxTileCache[(address << 1) | (xx & 1)];
                     
                     if ((color==0) && (((prio >> 25)&3) < 
                                        ((lineOBJ[sx]>>25)&3))) {
@@ -1356,65 +1511,25 @@ void gfxDrawSprites(void)
 void gfxDrawOBJWin(void)
 {
   gfxClearArray(lineOBJWin);
-  if(layerEnable & 0x8000) {
-    uint16 *sprites = (uint16 *)oam;
+  if(gfxRegs.layerEnable & 0x8000) {
+    const uint8 *list = gfxSpriteLines[gfxVCOUNT];
     // uint16 *spritePalette = &((uint16 *)paletteRAM)[256];
-    for(int i = 0; i < 128 ; i++) {
+
+    gfxSpriteListsUpdate();
+
+    for(int n = gfxSpriteLineCount[gfxVCOUNT]; n; n--) {
+      const uint16 *sprites = &((uint16 *)oam)[*list++ << 2];
       uint16 a0 = READ16LE(sprites++);
       uint16 a1 = READ16LE(sprites++);
-      uint16 a2 = READ16LE(sprites++);
-      sprites++;
+      uint16 a2 = READ16LE(sprites);
 
       // ignore non OBJ-WIN
       if((a0 & 0x0c00) != 0x0800)
         continue;
       
-      int sizeY = 8;
-      int sizeX = 8;
-      
-      switch(((a0 >>12) & 0x0c)|(a1>>14)) {
-      case 0:
-        break;
-      case 1:
-        sizeX = sizeY = 16;
-        break;
-      case 2:
-        sizeX = sizeY = 32;
-        break;
-      case 3:
-        sizeX = sizeY = 64;
-        break;
-      case 4:
-        sizeX = 16;
-        break;
-      case 5:
-        sizeX = 32;
-        break;
-      case 6:
-        sizeX = 32;
-        sizeY = 16;
-        break;
-      case 7:
-        sizeX = 64;
-        sizeY = 32;
-        break;
-      case 8:
-        sizeY = 16;
-        break;
-      case 9:
-        sizeY = 32;
-        break;
-      case 10:
-        sizeX = 16;
-        sizeY = 32;
-        break;
-      case 11:
-        sizeX = 32;
-        sizeY = 64;
-        break;
-      default:
-        continue;
-      }
+      const int shape = ((a0 >> 12) & 0x0c) | (a1 >> 14);
+      const int sizeX = gfxSpriteSizes[shape][0];
+      const int sizeY = gfxSpriteSizes[shape][1];
 
       int sy = (a0 & 255);
 
@@ -1429,7 +1544,7 @@ void gfxDrawOBJWin(void)
           fieldY <<= 1;
         }
         
-        int t = VCOUNT - sy;
+        int t = gfxVCOUNT - sy;
         if((t >= 0) && (t < fieldY)) {
           int sx = (a1 & 0x1FF);
           if((sx < 240) || (((sx + fieldX) & 511) < 240)) {
@@ -1458,10 +1573,10 @@ void gfxDrawOBJWin(void)
             
             if(a0 & 0x2000) {
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               int inc = 32;
-              if(DISPCNT & 0x40)
+              if(gfxRegs.DISPCNT & 0x40)
                 inc = sizeX >> 2;
               else
                 c &= 0x3FE;
@@ -1486,11 +1601,11 @@ void gfxDrawOBJWin(void)
               }
             } else {
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40)
+              if(gfxRegs.DISPCNT & 0x40)
                 inc = sizeX >> 3;
               // int palette = (a2 >> 8) & 0xF0;                      
               for(int x = 0; x < fieldX; x++) {
@@ -1526,7 +1641,7 @@ void gfxDrawOBJWin(void)
           }
         }
       } else {
-        int t = VCOUNT - sy;
+        int t = gfxVCOUNT - sy;
         if((t >= 0) && (t < sizeY)) {
           int sx = (a1 & 0x1FF);
           if(((sx < 240)||(((sx+sizeX)&511)<240)) && !(a0 & 0x0200)) {
@@ -1534,11 +1649,11 @@ void gfxDrawOBJWin(void)
               if(a1 & 0x2000)
                 t = sizeY - t - 1;
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40) {
+              if(gfxRegs.DISPCNT & 0x40) {
                 inc = sizeX >> 2;
               } else {
                 c &= 0x3FE;
@@ -1584,11 +1699,11 @@ void gfxDrawOBJWin(void)
               if(a1 & 0x2000)
                 t = sizeY - t - 1;
               int c = (a2 & 0x3FF);
-              if((DISPCNT & 7) > 2 && (c < 512))
+              if((gfxRegs.DISPCNT & 7) > 2 && (c < 512))
                 continue;
               
               int inc = 32;
-              if(DISPCNT & 0x40) {
+              if(gfxRegs.DISPCNT & 0x40) {
                 inc = sizeX >> 3;
               }
               int xxx = 0;
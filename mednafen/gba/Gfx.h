@@ -28,29 +28,11 @@
 
 //#define SPRITE_DEBUG
 
-void mode0RenderLine();
-void mode0RenderLineNoWindow();
-void mode0RenderLineAll();
+typedef void (*gfxRenderFunc)(void);
 
-void mode1RenderLine();
-void mode1RenderLineNoWindow();
-void mode1RenderLineAll();
-
-void mode2RenderLine();
-void mode2RenderLineNoWindow();
-void mode2RenderLineAll();
-
-void mode3RenderLine();
-void mode3RenderLineNoWindow();
-void mode3RenderLineAll();
-
-void mode4RenderLine();
-void mode4RenderLineNoWindow();
-void mode4RenderLineAll();
-
-void mode5RenderLine();
-void mode5RenderLineNoWindow();
-void mode5RenderLineAll();
+// The renderLine of a mode from 0 to 5, with or without the window and OBJ
+// window masks, for a BLDMOD effect (0 for none).
+gfxRenderFunc gfxRenderLineSelect(int mode, bool window, int effect);
 
 extern int all_coeff[32];
 extern uint32 AlphaClampLUT[64];
@@ -64,6 +46,54 @@ extern MDFN_ALIGN(16) uint32 lineMix[512];
 extern bool gfxInWin0[512];
 extern bool gfxInWin1[512];
 
+// The display registers a line is drawn with, which the renderers read
+// instead of the live ones in Globals.h.  They are copied at the time of
+// the line, so the render thread can draw it later while the CPU goes on
+// writing the registers.
+struct gfxLineRegs
+{
+  void (*renderLine)(void);
+  int layerEnable;
+  uint16 DISPCNT;
+  uint16 BG0CNT;
+  uint16 BG1CNT;
+  uint16 BG2CNT;
+  uint16 BG3CNT;
+  uint16 BGHOFS[4];
+  uint16 BGVOFS[4];
+  uint16 BG2PA;
+  uint16 BG2PB;
+  uint16 BG2PC;
+  uint16 BG2PD;
+  uint16 BG2X_L;
+  uint16 BG2X_H;
+  uint16 BG2Y_L;
+  uint16 BG2Y_H;
+  uint16 BG3PA;
+  uint16 BG3PB;
+  uint16 BG3PC;
+  uint16 BG3PD;
+  uint16 BG3X_L;
+  uint16 BG3X_H;
+  uint16 BG3Y_L;
+  uint16 BG3Y_H;
+  uint16 WIN0H;
+  uint16 WIN1H;
+  uint16 WIN0V;
+  uint16 WIN1V;
+  uint16 WININ;
+  uint16 WINOUT;
+  uint16 MOSAIC;
+  uint16 BLDMOD;
+  uint16 COLEV;
+  uint16 COLY;
+  uint8 BG2Changed;   // reference point writes since the previous line
+  uint8 BG3Changed;
+};
+
+extern gfxLineRegs gfxRegs;
+
+// Reference point writes the BG2/BG3 renderers haven't reloaded from yet.
 extern int gfxBG2Changed;
 extern int gfxBG3Changed;
 
@@ -77,4 +107,63 @@ extern int gfxBG3LastX;
 extern int gfxBG3LastY;
 extern int gfxLastVCOUNT;
 
+// Line drawn by renderLine.  It is VCOUNT except for lines drawn after
+// their time, by the render thread or after skipped lines.
+extern uint16 gfxVCOUNT;
+
+// One bit per 32 bytes of the first 96K of VRAM, set by every write to
+// them.  gfxTileCacheUpdate() decodes the 4bpp tiles of the marked bytes
+// again into gfxTileCache, which holds a palette index per pixel: the low
+// nibble of vram[n] is gfxTileCache[n * 2] and the high one the next byte.
+extern uint32 gfxTileDirty[0x18000 >> 10];
+extern uint8 gfxTileCache[0x18000 * 2];
+
+void gfxTileCacheUpdate(uint32 start, uint32 end);
+void gfxTileCacheInvalidate(void);
+
+static INLINE void gfxVramWritten(uint32 offset)
+{
+  gfxTileDirty[offset >> 10] |= 1 << ((offset >> 5) & 31);
+}
+
+// The BG palette in line buffer format, without the priority bits and with
+// the transparent colors already 0x80000000: gfxPalette16 for 16 color
+// tiles, where the first color of each bank is transparent, gfxPalette256
+// for 256 color ones, where only color 0 is.  gfxPaletteDirty has a bit
+// per bank of 16 colors written since they were built.
+extern uint32 gfxPalette16[256];
+extern uint32 gfxPalette256[256];
+extern uint32 gfxPaletteDirty;
+
+void gfxPaletteRebuild(void);
+
+static INLINE void gfxPaletteWritten(uint32 offset)
+{
+  if(offset < 0x200)
+    gfxPaletteDirty |= 1 << (offset >> 5);
+}
+
+static INLINE void gfxPaletteUpdate(void)
+{
+  if(gfxPaletteDirty)
+    gfxPaletteRebuild();
+}
+
+// Pixel of a gfxPalette16/256 entry at priority prio, without a branch on
+// transparency.
+static INLINE uint32 gfxPalettePixel(uint32 entry, uint32 prio)
+{
+  return entry | (prio & ~(uint32)((int32)entry >> 31));
+}
+
+// Set when OAM changes where the sprite positions, shapes or modes are,
+// for the per-line sprite lists to be built again before their next use.
+extern bool gfxSpriteListsDirty;
+
+static INLINE void gfxOamWritten(uint32 offset)
+{
+  if((offset & 7) < 4)
+    gfxSpriteListsDirty = true;
+}
+
 #endif // VBA_GFX_H
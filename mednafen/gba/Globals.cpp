@@ -20,12 +20,18 @@
 
 reg_pair reg[45];
 memoryMap map[256];
+memoryMap memoryReadPages[MEMORY_PAGES];
+memoryMap memoryWritePages[MEMORY_PAGES];
 bool ioReadable[0x400];
 
 uint32 N_FLAG = 0;
 bool C_FLAG = 0;
 bool Z_FLAG = 0;
 bool V_FLAG = 0;
+uint32 flagLhs = 0;
+uint32 flagRhs = 0;
+uint32 flagRes = 0;
+uint8 flagLazy = 0;
 
 bool armState = true;
 bool armIrqEnable = true;
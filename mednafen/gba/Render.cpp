@@ -0,0 +1,463 @@
+// VisualBoyAdvance - Nintendo Gameboy/GameboyAdvance (TM) emulator.
+// Copyright (C) 1999-2003 Forgotten
+// Copyright (C) 2004 Forgotten and the VBA development team
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2, or(at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "GBA.h"
+#include "Globals.h"
+#include "Gfx.h"
+#include "gfx-draw.h"
+
+// The line renderers of the six bitmap and tile modes.  They are one
+// template, specialized on the mode, on whether the window masks apply,
+// on the BLDMOD effect and on the OBJ window, so that each combination
+// compiles to a loop without the tests the others need.
+//
+// gfxModeLayers<mode> is the mask of the backgrounds a mode composites,
+// in the bit order of BLDMOD and the window masks.
+template<int MODE> struct gfxModeLayers { enum { value = 0x04 }; };
+template<> struct gfxModeLayers<0> { enum { value = 0x0F }; };
+template<> struct gfxModeLayers<1> { enum { value = 0x07 }; };
+template<> struct gfxModeLayers<2> { enum { value = 0x0C }; };
+
+// Backgrounds turned off since the previous line leave their line buffer
+// transparent.
+static void gfxClearLayers(void)
+{
+  static int last = 0;
+  const int off = last & ~gfxRegs.layerEnable;
+
+  if(off & 0x0100)
+    MDFN_FastU32MemsetM8(line0, 0x80000000, 240);
+  if(off & 0x0200)
+    MDFN_FastU32MemsetM8(line1, 0x80000000, 240);
+  if(off & 0x0400)
+    MDFN_FastU32MemsetM8(line2, 0x80000000, 240);
+  if(off & 0x0800)
+    MDFN_FastU32MemsetM8(line3, 0x80000000, 240);
+  last = gfxRegs.layerEnable & 0x0F00;
+}
+
+// Marks the pixels inside the horizontal range winh of a window.
+static void gfxWindowRange(bool *in, uint16 winh)
+{
+  int x00 = winh >> 8;
+  int x01 = winh & 255;
+
+  if(x00 <= x01) {
+    for(int i = 0; i < 240; i++) {
+      in[i] = (i >= x00 && i < x01);
+    }
+  } else {
+    for(int i = 0; i < 240; i++) {
+      in[i] = (i >= x00 || i < x01);
+    }
+  }
+}
+
+// gfxInWin0 and gfxInWin1 for the WIN0H and WIN1H of the line.
+static INLINE void gfxWindowsUpdate(void)
+{
+  static int last0 = -1;
+  static int last1 = -1;
+
+  if(gfxRegs.WIN0H != last0) {
+    last0 = gfxRegs.WIN0H;
+    gfxWindowRange(gfxInWin0, gfxRegs.WIN0H);
+  }
+  if(gfxRegs.WIN1H != last1) {
+    last1 = gfxRegs.WIN1H;
+    gfxWindowRange(gfxInWin1, gfxRegs.WIN1H);
+  }
+}
+
+template<int MODE>
+static INLINE void gfxDrawLayers(void)
+{
+  const gfxLineRegs &r = gfxRegs;
+
+  if(MODE < 2) {
+    if(r.layerEnable & 0x0100) {
+      gfxDrawTextScreen(r.BG0CNT, r.BGHOFS[0], r.BGVOFS[0], line0);
+    }
+
+    if(r.layerEnable & 0x0200) {
+      gfxDrawTextScreen(r.BG1CNT, r.BGHOFS[1], r.BGVOFS[1], line1);
+    }
+  }
+
+  if(r.layerEnable & 0x0400) {
+    if(MODE == 0) {
+      gfxDrawTextScreen(r.BG2CNT, r.BGHOFS[2], r.BGVOFS[2], line2);
+    } else {
+      int changed = gfxBG2Changed;
+      if(gfxLastVCOUNT > gfxVCOUNT)
+        changed = 3;
+
+      switch(MODE) {
+      case 1:
+      case 2:
+        gfxDrawRotScreen(r.BG2CNT, r.BG2X_L, r.BG2X_H, r.BG2Y_L, r.BG2Y_H,
+                         r.BG2PA, r.BG2PB, r.BG2PC, r.BG2PD,
+                         gfxBG2X, gfxBG2Y, changed, line2);
+        break;
+      case 3:
+        gfxDrawRotScreen16Bit(r.BG2CNT, r.BG2X_L, r.BG2X_H, r.BG2Y_L, r.BG2Y_H,
+                              r.BG2PA, r.BG2PB, r.BG2PC, r.BG2PD,
+                              gfxBG2X, gfxBG2Y, changed, line2);
+        break;
+      case 4:
+        gfxDrawRotScreen256(r.BG2CNT, r.BG2X_L, r.BG2X_H, r.BG2Y_L, r.BG2Y_H,
+                            r.BG2PA, r.BG2PB, r.BG2PC, r.BG2PD,
+                            gfxBG2X, gfxBG2Y, changed, line2);
+        break;
+      case 5:
+        gfxDrawRotScreen16Bit160(r.BG2CNT, r.BG2X_L, r.BG2X_H, r.BG2Y_L, r.BG2Y_H,
+                                 r.BG2PA, r.BG2PB, r.BG2PC, r.BG2PD,
+                                 gfxBG2X, gfxBG2Y, changed, line2);
+        break;
+      }
+    }
+  }
+
+  if((gfxModeLayers<MODE>::value & 0x08) && (r.layerEnable & 0x0800)) {
+    if(MODE == 0) {
+      gfxDrawTextScreen(r.BG3CNT, r.BGHOFS[3], r.BGVOFS[3], line3);
+    } else {
+      int changed = gfxBG3Changed;
+      if(gfxLastVCOUNT > gfxVCOUNT)
+        changed = 3;
+
+      gfxDrawRotScreen(r.BG3CNT, r.BG3X_L, r.BG3X_H, r.BG3Y_L, r.BG3Y_H,
+                       r.BG3PA, r.BG3PB, r.BG3PC, r.BG3PD,
+                       gfxBG3X, gfxBG3Y, changed, line3);
+    }
+  }
+}
+
+// Takes line[x] as the new color when its layer is one of enabled and it
+// is in front of color.
+static INLINE void gfxSelect(uint32 &color, uint8 &top, const uint32 *line,
+                             int x, uint8 id, uint8 enabled)
+{
+  if((enabled & id) && line[x] < (color & 0xFF000000)) {
+    color = line[x];
+    top = id;
+  }
+}
+
+// One pixel of the line, mask being the layers and effect enable of the
+// window it is in (0x3F outside of the window renderers).
+template<int LAYERS, int FX>
+static INLINE uint32 gfxMixPixel(int x, uint32 backdrop, uint8 mask)
+{
+  const uint8 layers = LAYERS & mask;
+  uint32 color = backdrop;
+  uint8 top = 0x20;
+
+  gfxSelect(color, top, line0, x, 0x01, layers);
+  gfxSelect(color, top, line1, x, 0x02, layers);
+  gfxSelect(color, top, line2, x, 0x04, layers);
+  gfxSelect(color, top, line3, x, 0x08, layers);
+  gfxSelect(color, top, lineOBJ, x, 0x10, mask);
+
+  if(!(color & 0x00010000)) {
+    if(!(mask & 32) || !(gfxRegs.BLDMOD & top))
+      return color;
+
+    switch(FX) {
+    case 1:
+      {
+        // the first layer behind top
+        uint32 back = backdrop;
+        uint8 top2 = 0x20;
+
+        gfxSelect(back, top2, line0, x, 0x01, layers & ~top);
+        gfxSelect(back, top2, line1, x, 0x02, layers & ~top);
+        gfxSelect(back, top2, line2, x, 0x04, layers & ~top);
+        gfxSelect(back, top2, line3, x, 0x08, layers & ~top);
+        gfxSelect(back, top2, lineOBJ, x, 0x10, mask & ~top);
+
+        if(top2 & (gfxRegs.BLDMOD>>8))
+          color = gfxAlphaBlend(color, back,
+                                all_coeff[gfxRegs.COLEV & 0x1F],
+                                all_coeff[(gfxRegs.COLEV >> 8) & 0x1F]);
+      }
+      break;
+    case 2:
+      color = gfxIncreaseBrightness(color, all_coeff[gfxRegs.COLY & 0x1F]);
+      break;
+    case 3:
+      color = gfxDecreaseBrightness(color, all_coeff[gfxRegs.COLY & 0x1F]);
+      break;
+    }
+  } else {
+    // semi-transparent OBJ
+    uint32 back = backdrop;
+    uint8 top2 = 0x20;
+
+    gfxSelect(back, top2, line0, x, 0x01, layers);
+    gfxSelect(back, top2, line1, x, 0x02, layers);
+    gfxSelect(back, top2, line2, x, 0x04, layers);
+    gfxSelect(back, top2, line3, x, 0x08, layers);
+
+    if(top2 & (gfxRegs.BLDMOD>>8))
+      color = gfxAlphaBlend(color, back,
+                            all_coeff[gfxRegs.COLEV & 0x1F],
+                            all_coeff[(gfxRegs.COLEV >> 8) & 0x1F]);
+    else if(FX >= 2 && (gfxRegs.BLDMOD & top)) {
+      if(FX == 2)
+        color = gfxIncreaseBrightness(color, all_coeff[gfxRegs.COLY & 0x1F]);
+      else
+        color = gfxDecreaseBrightness(color, all_coeff[gfxRegs.COLY & 0x1F]);
+    }
+  }
+
+  return color;
+}
+
+#ifdef __SSE2__
+// The window masks of the four pixels from x, the way gfxWindowMask()
+// picks them.
+template<bool OBJWIN>
+static INLINE __m128i gfxWindowMask4(int x, bool inWindow0, bool inWindow1)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i mask = _mm_set1_epi32(gfxRegs.WINOUT & 0xFF);
+  uint32 in;
+
+  if(OBJWIN) {
+    __m128i out = _mm_srai_epi32(_mm_load_si128((const __m128i *)&lineOBJWin[x]), 31);
+    mask = gfxBlend4(out, mask, _mm_set1_epi32(gfxRegs.WINOUT >> 8));
+  }
+  if(inWindow1) {
+    memcpy(&in, &gfxInWin1[x], 4);
+    __m128i out = _mm_cmpeq_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(in), zero), zero), zero);
+    mask = gfxBlend4(out, mask, _mm_set1_epi32(gfxRegs.WININ >> 8));
+  }
+  if(inWindow0) {
+    memcpy(&in, &gfxInWin0[x], 4);
+    __m128i out = _mm_cmpeq_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(in), zero), zero), zero);
+    mask = gfxBlend4(out, mask, _mm_set1_epi32(gfxRegs.WININ & 0xFF));
+  }
+  return mask;
+}
+
+// gfxMixPixel() on the whole line, four pixels at a time, WINDOW and
+// OBJWIN as for gfxRenderLine().
+template<int LAYERS, int FX, bool WINDOW, bool OBJWIN>
+static void gfxMixLine4(uint32 backdrop, bool inWindow0, bool inWindow1)
+{
+  const int ca = all_coeff[gfxRegs.COLEV & 0x1F];
+  const int cb = all_coeff[(gfxRegs.COLEV >> 8) & 0x1F];
+  const int cy = all_coeff[gfxRegs.COLY & 0x1F];
+  const int first = gfxRegs.BLDMOD & 0x3F;
+  const int second = (gfxRegs.BLDMOD >> 8) & 0x3F;
+
+  for(int x = 0; x < 240; x += 4) {
+    const __m128i mask = WINDOW ? gfxWindowMask4<OBJWIN>(x, inWindow0, inWindow1) : _mm_set1_epi32(0x3F);
+    const __m128i layers = _mm_and_si128(mask, _mm_set1_epi32(LAYERS));
+    __m128i color = _mm_set1_epi32(backdrop ^ 0x80000000);
+    __m128i top = _mm_set1_epi32(0x20);
+
+    if(LAYERS & 0x01)
+      gfxSelect4(color, top, line0, x, 0x01, layers);
+    if(LAYERS & 0x02)
+      gfxSelect4(color, top, line1, x, 0x02, layers);
+    if(LAYERS & 0x04)
+      gfxSelect4(color, top, line2, x, 0x04, layers);
+    if(LAYERS & 0x08)
+      gfxSelect4(color, top, line3, x, 0x08, layers);
+    gfxSelect4(color, top, lineOBJ, x, 0x10, mask);
+    color = _mm_xor_si128(color, _mm_set1_epi32(0x80000000));
+
+    // semi-transparent OBJ blend whatever the window says, the others
+    // when the window enables effects and top is a first target
+    const __m128i semi = gfxTest4(color, 0x00010000);
+    const __m128i isFirst = gfxTest4(top, first);
+    const __m128i fx = FX ? _mm_andnot_si128(semi, _mm_and_si128(isFirst, gfxTest4(mask, 32))) :
+                            _mm_setzero_si128();
+    const __m128i alpha = FX == 1 ? _mm_or_si128(semi, fx) : semi;
+
+    if(_mm_movemask_epi8(_mm_or_si128(alpha, fx))) {
+      __m128i bright = fx;
+
+      if(_mm_movemask_epi8(alpha)) {
+        // the first layer behind top, which is the OBJ itself when it is
+        // semi-transparent
+        const __m128i behind = _mm_andnot_si128(top, layers);
+        __m128i back = _mm_set1_epi32(backdrop ^ 0x80000000);
+        __m128i top2 = _mm_set1_epi32(0x20);
+
+        if(LAYERS & 0x01)
+          gfxSelect4(back, top2, line0, x, 0x01, behind);
+        if(LAYERS & 0x02)
+          gfxSelect4(back, top2, line1, x, 0x02, behind);
+        if(LAYERS & 0x04)
+          gfxSelect4(back, top2, line2, x, 0x04, behind);
+        if(LAYERS & 0x08)
+          gfxSelect4(back, top2, line3, x, 0x08, behind);
+        if(FX == 1)
+          gfxSelect4(back, top2, lineOBJ, x, 0x10, _mm_andnot_si128(_mm_or_si128(top, semi), mask));
+        back = _mm_xor_si128(back, _mm_set1_epi32(0x80000000));
+
+        const __m128i blend = _mm_and_si128(alpha, gfxTest4(top2, second));
+
+        if(FX >= 2)
+          bright = _mm_or_si128(bright, _mm_andnot_si128(blend, _mm_and_si128(semi, isFirst)));
+        if(_mm_movemask_epi8(blend))
+          color = gfxBlend4(blend, gfxAlphaBlend4(color, back, ca, cb), color);
+      }
+
+      if(FX >= 2 && _mm_movemask_epi8(bright))
+        color = gfxBlend4(bright, gfxBrightness4(color, cy, FX == 2), color);
+    }
+
+    _mm_store_si128((__m128i *)&lineMix[x], color);
+  }
+}
+
+#endif
+
+// The window mask of pixel x: the innermost of window 0, window 1, the
+// OBJ window and the outside it is in.
+template<bool OBJWIN>
+static INLINE uint8 gfxWindowMask(int x, bool inWindow0, bool inWindow1)
+{
+  if(inWindow0 && gfxInWin0[x])
+    return gfxRegs.WININ & 0xFF;
+  if(inWindow1 && gfxInWin1[x])
+    return gfxRegs.WININ >> 8;
+  if(OBJWIN && !(lineOBJWin[x] & 0x80000000))
+    return gfxRegs.WINOUT >> 8;
+  return gfxRegs.WINOUT & 0xFF;
+}
+
+template<int MODE, bool WINDOW, int FX, bool OBJWIN>
+static void gfxRenderLine(void)
+{
+  const int layers = gfxModeLayers<MODE>::value;
+  uint16 *palette = (uint16 *)paletteRAM;
+
+  gfxClearLayers();
+
+  if(gfxRegs.DISPCNT & 0x80) {
+    for(int x = 0; x < 240; x++) {
+      lineMix[x] = 0x7fff;
+    }
+    if(MODE)
+      gfxLastVCOUNT = gfxVCOUNT;
+    return;
+  }
+
+  bool inWindow0 = false;
+  bool inWindow1 = false;
+
+  if(WINDOW)
+    gfxWindowsUpdate();
+
+  if(WINDOW && (gfxRegs.layerEnable & 0x2000)) {
+    uint8 v0 = gfxRegs.WIN0V >> 8;
+    uint8 v1 = gfxRegs.WIN0V & 255;
+    inWindow0 = ((v0 == v1) && (v0 >= 0xe8));
+    if(v1 >= v0)
+      inWindow0 |= (gfxVCOUNT >= v0 && gfxVCOUNT < v1);
+    else
+      inWindow0 |= (gfxVCOUNT >= v0 || gfxVCOUNT < v1);
+  }
+  if(WINDOW && (gfxRegs.layerEnable & 0x4000)) {
+    uint8 v0 = gfxRegs.WIN1V >> 8;
+    uint8 v1 = gfxRegs.WIN1V & 255;
+    inWindow1 = ((v0 == v1) && (v0 >= 0xe8));
+    if(v1 >= v0)
+      inWindow1 |= (gfxVCOUNT >= v0 && gfxVCOUNT < v1);
+    else
+      inWindow1 |= (gfxVCOUNT >= v0 || gfxVCOUNT < v1);
+  }
+
+  gfxDrawLayers<MODE>();
+
+  gfxDrawSprites();
+  if(OBJWIN)
+    gfxDrawOBJWin();
+
+  uint32 backdrop = (READ16LE(&palette[0]) | 0x30000000);
+
+#ifdef __SSE2__
+  gfxMixLine4<layers, FX, WINDOW, OBJWIN>(backdrop, inWindow0, inWindow1);
+#ifdef GFX_MIX_CHECK
+  for(int x = 0; x < 240; x++) {
+    uint8 mask = WINDOW ? gfxWindowMask<OBJWIN>(x, inWindow0, inWindow1) : 0x3F;
+
+    if(lineMix[x] != gfxMixPixel<layers, FX>(x, backdrop, mask)) {
+      MDFN_printf("gfxMixLine4: line %d pixel %d is %08x, gfxMixPixel gives %08x\n", gfxVCOUNT, x,
+                  lineMix[x], gfxMixPixel<layers, FX>(x, backdrop, mask));
+      abort();
+    }
+  }
+#endif
+#else
+  for(int x = 0; x < 240; x++) {
+    uint8 mask = WINDOW ? gfxWindowMask<OBJWIN>(x, inWindow0, inWindow1) : 0x3F;
+
+    lineMix[x] = gfxMixPixel<layers, FX>(x, backdrop, mask);
+  }
+#endif
+
+  if(MODE) {
+    gfxBG2Changed = 0;
+    if(MODE == 2)
+      gfxBG3Changed = 0;
+    gfxLastVCOUNT = gfxVCOUNT;
+  }
+}
+
+// The OBJ window follows layerEnable, which can change after the renderer
+// was picked, so it is chosen line by line.
+template<int MODE, int FX>
+static void gfxRenderLineWindow(void)
+{
+  if(gfxRegs.layerEnable & 0x8000)
+    gfxRenderLine<MODE, true, FX, true>();
+  else
+    gfxRenderLine<MODE, true, FX, false>();
+}
+
+#define GFX_RENDER_MODE(mode) \
+  { { gfxRenderLine<mode, false, 0, false>, \
+      gfxRenderLine<mode, false, 1, false>, \
+      gfxRenderLine<mode, false, 2, false>, \
+      gfxRenderLine<mode, false, 3, false> }, \
+    { gfxRenderLineWindow<mode, 0>, \
+      gfxRenderLineWindow<mode, 1>, \
+      gfxRenderLineWindow<mode, 2>, \
+      gfxRenderLineWindow<mode, 3> } }
+
+static void (* const gfxRenderLines[6][2][4])(void) = {
+  GFX_RENDER_MODE(0),
+  GFX_RENDER_MODE(1),
+  GFX_RENDER_MODE(2),
+  GFX_RENDER_MODE(3),
+  GFX_RENDER_MODE(4),
+  GFX_RENDER_MODE(5)
+};
+
+#undef GFX_RENDER_MODE
+
+gfxRenderFunc gfxRenderLineSelect(int mode, bool window, int effect)
+{
+  return gfxRenderLines[mode][window][effect];
+}
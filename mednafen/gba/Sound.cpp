@@ -346,6 +346,11 @@ static void DSTimer(int which, int dmamask)
  }
 }
 
+bool soundTimerUsed(int timer)
+{
+ return (soundDSAEnabled && (soundDSATimer == timer)) || (soundDSBEnabled && (soundDSBTimer == timer));
+}
+
 void soundTimerOverflow(int timer)
 {
  bool NeedLick = false;
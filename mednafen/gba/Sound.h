@@ -51,6 +51,7 @@ extern void soundReset();
 extern void soundEvent(uint32, uint8);
 extern void soundEvent(uint32, uint16);
 extern void soundTimerOverflow(int);
+extern bool soundTimerUsed(int);
 
 int32 MDFNGBASOUND_Flush(int16 *SoundBuf, const int32 MaxSoundFrames);
 void MDFNGBASOUND_Init(void);
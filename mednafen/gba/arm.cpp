@@ -35,7 +35,7 @@ unsigned int RunARM(void)
       \
       N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
       Z_FLAG = (reg[dest].I) ? false : true;\
-      C_FLAG = C_OUT;
+      SET_C_FLAG(C_OUT);
 
 #define OP_EOR \
       reg[dest].I = reg[(opcode>>16)&15].I ^ value;
@@ -45,24 +45,10 @@ unsigned int RunARM(void)
       \
       N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
       Z_FLAG = (reg[dest].I) ? false : true;\
-      C_FLAG = C_OUT;
+      SET_C_FLAG(C_OUT);
 
 #define NEG(i) ((i) >> 31)
 #define POS(i) ((~(i)) >> 31)
-#define ADDCARRY(a, b, c) \
-  C_FLAG = ((NEG(a) & NEG(b)) |\
-            (NEG(a) & POS(c)) |\
-            (NEG(b) & POS(c))) ? true : false;
-#define ADDOVERFLOW(a, b, c) \
-  V_FLAG = ((NEG(a) & NEG(b) & POS(c)) |\
-            (POS(a) & POS(b) & NEG(c))) ? true : false;
-#define SUBCARRY(a, b, c) \
-  C_FLAG = ((NEG(a) & POS(b)) |\
-            (NEG(a) & POS(c)) |\
-            (POS(b) & POS(c))) ? true : false;
-#define SUBOVERFLOW(a, b, c)\
-  V_FLAG = ((NEG(a) & POS(b) & POS(c)) |\
-            (POS(a) & NEG(b) & NEG(c))) ? true : false;
 #define OP_SUB \
     {\
       reg[dest].I = reg[base].I - value;\
@@ -75,8 +61,7 @@ unsigned int RunARM(void)
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     SUBCARRY(lhs, rhs, res);\
-     SUBOVERFLOW(lhs, rhs, res);\
+     SET_SUB_FLAGS(lhs, rhs, res);\
    }
 #define OP_RSB \
     {\
@@ -90,8 +75,7 @@ unsigned int RunARM(void)
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     SUBCARRY(rhs, lhs, res);\
-     SUBOVERFLOW(rhs, lhs, res);\
+     SET_SUB_FLAGS(rhs, lhs, res);\
    }
 #define OP_ADD \
     {\
@@ -105,53 +89,49 @@ unsigned int RunARM(void)
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     ADDCARRY(lhs, rhs, res);\
-     ADDOVERFLOW(lhs, rhs, res);\
+     SET_ADD_FLAGS(lhs, rhs, res);\
    }
 #define OP_ADC \
     {\
-      reg[dest].I = reg[base].I + value + (uint32)C_FLAG;\
+      reg[dest].I = reg[base].I + value + (uint32)GET_C_FLAG();\
     }
 #define OP_ADCS \
    {\
      uint32 lhs = reg[base].I;\
      uint32 rhs = value;\
-     uint32 res = lhs + rhs + (uint32)C_FLAG;\
+     uint32 res = lhs + rhs + (uint32)GET_C_FLAG();\
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     ADDCARRY(lhs, rhs, res);\
-     ADDOVERFLOW(lhs, rhs, res);\
+     SET_ADD_FLAGS(lhs, rhs, res);\
    }
 #define OP_SBC \
     {\
-      reg[dest].I = reg[base].I - value - !((uint32)C_FLAG);\
+      reg[dest].I = reg[base].I - value - !((uint32)GET_C_FLAG());\
     }
 #define OP_SBCS \
    {\
      uint32 lhs = reg[base].I;\
      uint32 rhs = value;\
-     uint32 res = lhs - rhs - !((uint32)C_FLAG);\
+     uint32 res = lhs - rhs - !((uint32)GET_C_FLAG());\
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     SUBCARRY(lhs, rhs, res);\
-     SUBOVERFLOW(lhs, rhs, res);\
+     SET_SUB_FLAGS(lhs, rhs, res);\
    }
 #define OP_RSC \
     {\
-      reg[dest].I = value - reg[base].I - !((uint32)C_FLAG);\
+      reg[dest].I = value - reg[base].I - !((uint32)GET_C_FLAG());\
     }
 #define OP_RSCS \
    {\
      uint32 lhs = reg[base].I;\
      uint32 rhs = value;\
-     uint32 res = rhs - lhs - !((uint32)C_FLAG);\
+     uint32 res = rhs - lhs - !((uint32)GET_C_FLAG());\
      reg[dest].I = res;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     SUBCARRY(rhs, lhs, res);\
-     SUBOVERFLOW(rhs, lhs, res);\
+     SET_SUB_FLAGS(rhs, lhs, res);\
    }
 #define OP_CMP \
    {\
@@ -160,8 +140,7 @@ unsigned int RunARM(void)
      uint32 res = lhs - rhs;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     SUBCARRY(lhs, rhs, res);\
-     SUBOVERFLOW(lhs, rhs, res);\
+     SET_SUB_FLAGS(lhs, rhs, res);\
    }
 #define OP_CMN \
    {\
@@ -170,8 +149,7 @@ unsigned int RunARM(void)
      uint32 res = lhs + rhs;\
      Z_FLAG = (res == 0) ? true : false;\
      N_FLAG = NEG(res) ? true : false;\
-     ADDCARRY(lhs, rhs, res);\
-     ADDOVERFLOW(lhs, rhs, res);\
+     SET_ADD_FLAGS(lhs, rhs, res);\
    }
 
 #define LOGICAL_LSL_REG \
@@ -202,7 +180,7 @@ unsigned int RunARM(void)
 #define LOGICAL_RRX_REG \
    {\
      uint32 v = reg[opcode & 0x0f].I;\
-     shift = (int)C_FLAG;\
+     shift = (int)GET_C_FLAG();\
      C_OUT = (v  & 1) ? true : false;\
      value = ((v >> 1) |\
               (shift << 31));\
@@ -238,7 +216,7 @@ unsigned int RunARM(void)
 #define ARITHMETIC_RRX_REG \
    {\
      uint32 v = reg[opcode & 0x0f].I;\
-     shift = (int)C_FLAG;\
+     shift = (int)GET_C_FLAG();\
      value = ((v >> 1) |\
               (shift << 31));\
    }
@@ -261,7 +239,7 @@ unsigned int RunARM(void)
    }
 #define RCR_VALUE \
    {\
-     shift = (int)C_FLAG;\
+     shift = (int)GET_C_FLAG();\
      value = ((value >> 1) |\
               (shift << 31));\
    }
@@ -270,13 +248,13 @@ unsigned int RunARM(void)
       uint32 res = reg[base].I & value;\
       N_FLAG = (res & 0x80000000) ? true : false;\
       Z_FLAG = (res) ? false : true;\
-      C_FLAG = C_OUT;
+      SET_C_FLAG(C_OUT);
 
 #define OP_TEQ \
       uint32 res = reg[base].I ^ value;\
       N_FLAG = (res & 0x80000000) ? true : false;\
       Z_FLAG = (res) ? false : true;\
-      C_FLAG = C_OUT;
+      SET_C_FLAG(C_OUT);
 
 #define OP_ORR \
     reg[dest].I = reg[base].I | value;
@@ -285,7 +263,7 @@ unsigned int RunARM(void)
     reg[dest].I = reg[base].I | value;\
     N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
     Z_FLAG = (reg[dest].I) ? false : true;\
-    C_FLAG = C_OUT;
+    SET_C_FLAG(C_OUT);
 
 #define OP_MOV \
     reg[dest].I = value;
@@ -294,7 +272,7 @@ unsigned int RunARM(void)
     reg[dest].I = value;\
     N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
     Z_FLAG = (reg[dest].I) ? false : true;\
-    C_FLAG = C_OUT;
+    SET_C_FLAG(C_OUT);
 
 #define OP_BIC \
     reg[dest].I = reg[base].I & (~value);
@@ -303,7 +281,7 @@ unsigned int RunARM(void)
     reg[dest].I = reg[base].I & (~value);\
     N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
     Z_FLAG = (reg[dest].I) ? false : true;\
-    C_FLAG = C_OUT;
+    SET_C_FLAG(C_OUT);
 
 #define OP_MVN \
     reg[dest].I = ~value;
@@ -312,7 +290,7 @@ unsigned int RunARM(void)
     reg[dest].I = ~value; \
     N_FLAG = (reg[dest].I & 0x80000000) ? true : false;\
     Z_FLAG = (reg[dest].I) ? false : true;\
-    C_FLAG = C_OUT;
+    SET_C_FLAG(C_OUT);
 
 #define CASE_16(BASE) \
   case BASE:\
@@ -358,7 +336,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       \
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
@@ -402,7 +380,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -447,7 +425,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -497,7 +475,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -539,7 +517,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -589,7 +567,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -639,7 +617,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -691,7 +669,7 @@ unsigned int RunARM(void)
       int base = (opcode >> 16) & 0x0F;\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -754,7 +732,7 @@ unsigned int RunARM(void)
       int shift = (opcode & 0xF00) >> 7;\
       int base = (opcode >> 16) & 0x0F;\
       int dest = (opcode >> 12) & 0x0F;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -798,7 +776,7 @@ unsigned int RunARM(void)
       /* OP Rd,Rb,Rm LSL # */ \
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -841,7 +819,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm LSR # */ \
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -885,7 +863,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm ASR # */\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -934,7 +912,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm ROR # */\
       int shift = (opcode >> 7) & 0x1F;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -975,7 +953,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm LSL Rs */\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -1024,7 +1002,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm LSR Rs */ \
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -1073,7 +1051,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm ASR Rs */ \
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -1124,7 +1102,7 @@ unsigned int RunARM(void)
        /* OP Rd,Rb,Rm ROR Rs */\
       int shift = reg[(opcode >> 8)&15].B.B0;\
       int dest = (opcode>>12) & 15;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -1186,7 +1164,7 @@ unsigned int RunARM(void)
     {\
       int shift = (opcode & 0xF00) >> 7;\
       int dest = (opcode >> 12) & 0x0F;\
-      bool C_OUT MDFN_NOWARN_UNUSED = C_FLAG;\
+      bool C_OUT MDFN_NOWARN_UNUSED = GET_C_FLAG();\
       uint32 value;\
       if ((dest == 15)||((opcode & 0x02000010)==0x10))\
       {\
@@ -1631,6 +1609,8 @@ unsigned int RunARM(void)
     }\
     break;
 
+ // one instruction per pass until CPUEndStep() ends the slice
+ for(;;) {
   uint32 opcode = cpuPrefetch[0];
   cpuPrefetch[0] = cpuPrefetch[1];
 
@@ -1666,10 +1646,10 @@ unsigned int RunARM(void)
       cond_res = !Z_FLAG;
       break;
     case 0x02: // CS
-      cond_res = C_FLAG;
+      cond_res = GET_C_FLAG();
       break;
     case 0x03: // CC
-      cond_res = !C_FLAG;
+      cond_res = !GET_C_FLAG();
       break;
     case 0x04: // MI
       cond_res = N_FLAG;
@@ -1678,28 +1658,28 @@ unsigned int RunARM(void)
       cond_res = !N_FLAG;
       break;
     case 0x06: // VS
-      cond_res = V_FLAG;
+      cond_res = GET_V_FLAG();
       break;
     case 0x07: // VC
-      cond_res = !V_FLAG;
+      cond_res = !GET_V_FLAG();
       break;
     case 0x08: // HI
-      cond_res = C_FLAG && !Z_FLAG;
+      cond_res = GET_C_FLAG() && !Z_FLAG;
       break;
     case 0x09: // LS
-      cond_res = !C_FLAG || Z_FLAG;
+      cond_res = !GET_C_FLAG() || Z_FLAG;
       break;
     case 0x0A: // GE
-      cond_res = N_FLAG == V_FLAG;
+      cond_res = N_FLAG == GET_V_FLAG();
       break;
     case 0x0B: // LT
-      cond_res = N_FLAG != V_FLAG;
+      cond_res = N_FLAG != GET_V_FLAG();
       break;
     case 0x0C: // GT
-      cond_res = !Z_FLAG &&(N_FLAG == V_FLAG);
+      cond_res = !Z_FLAG &&(N_FLAG == GET_V_FLAG());
       break;
     case 0x0D: // LE
-      cond_res = Z_FLAG || (N_FLAG != V_FLAG);
+      cond_res = Z_FLAG || (N_FLAG != GET_V_FLAG());
       break;
     case 0x0E:
       cond_res = true;
@@ -7937,5 +7917,7 @@ if(cond_res) {
  if (clockTicks == 0)
   clockTicks = codeTicksAccessSeq32(oldArmNextPC) + 1;
 
- return(clockTicks);
+ if(CPUEndStep(oldArmNextPC, clockTicks, false))
+  return(clockTicks);
+ }
 }
@@ -58,6 +58,132 @@ static const int16 sineTable[256] = {
   (int16)0xF384, (int16)0xF50F, (int16)0xF69C, (int16)0xF82B, (int16)0xF9BB, (int16)0xFB4B, (int16)0xFCDD, (int16)0xFE6E
 };
 
+// Plain memory that a BIOS routine reads or writes through a host pointer.
+// Accesses outside of it go through the memory handlers as before.
+struct biosWindow
+{
+  uint32 address;
+  uint32 size;
+  uint8 *host;
+};
+
+static void BIOS_ReadWindow(biosWindow &w, uint32 address, uint32 max)
+{
+  w.address = address;
+  w.size = CPUHostSpan(memoryReadPages, address, max, &w.host);
+}
+
+// Byte writes to palette RAM, VRAM and OAM are special, so there a window
+// is only opened for halfword and word writes.
+static void BIOS_WriteWindow(biosWindow &w, uint32 address, uint32 max, bool bytes)
+{
+  w.address = address;
+  w.size = 0;
+  if(!bytes || (address >> 25) == 1)
+    w.size = CPUHostSpan(memoryWritePages, address, max, &w.host);
+  if(w.size)
+    CPUHostWritten(address, w.size);
+}
+
+// Fills the leading units of count at dest that are plain memory, in
+// multiples of step units.  Returns the number of units filled.
+static uint32 BIOS_HostFill(uint32 dest, uint32 count, uint32 value, uint32 size, uint32 step)
+{
+  biosWindow dst;
+
+  if(dest & (size - 1))
+    return 0;
+
+  BIOS_WriteWindow(dst, dest, count * size, false);
+
+  const uint32 n = (dst.size / size) & ~(step - 1);
+
+  if(!n)
+    return 0;
+  if(!value)
+    memset(dst.host, 0, n * size);
+  else if(size == 4) {
+    for(uint32 i = 0; i < n; i++)
+      WRITE32LE((uint32 *)dst.host + i, value);
+  } else {
+    for(uint32 i = 0; i < n; i++)
+      WRITE16LE((uint16 *)dst.host + i, value);
+  }
+  return n;
+}
+
+// Copies the leading units of count from source to dest that are plain
+// memory on both sides, in multiples of step units.  Returns the number of
+// units copied.
+static uint32 BIOS_HostCopy(uint32 source, uint32 dest, uint32 count, uint32 size, uint32 step)
+{
+  biosWindow src, dst;
+
+  if((source | dest) & (size - 1))
+    return 0;
+
+  BIOS_ReadWindow(src, source, count * size);
+  if(src.size < size * step)
+    return 0;
+  BIOS_WriteWindow(dst, dest, src.size, false);
+
+  const uint32 n = (dst.size / size) & ~(step - 1);
+
+  if(!n)
+    return 0;
+  // copying forward onto itself replicates, which memmove won't
+  if(dst.host > src.host && dst.host < src.host + n * size)
+    return 0;
+  memmove(dst.host, src.host, n * size);
+  return n;
+}
+
+static INLINE uint8 BIOS_ReadByte(const biosWindow &w, uint32 address)
+{
+  const uint32 offset = address - w.address;
+
+  return offset < w.size ? w.host[offset] : CPUReadByte(address);
+}
+
+static INLINE uint32 BIOS_ReadWord(const biosWindow &w, uint32 address)
+{
+  const uint32 offset = address - w.address;
+
+  if(offset < w.size && w.size - offset >= 4 && !(address & 3))
+    return READ32LE((uint32 *)(w.host + offset));
+  return CPUReadMemory(address);
+}
+
+static INLINE void BIOS_WriteByte(const biosWindow &w, uint32 address, uint8 b)
+{
+  const uint32 offset = address - w.address;
+
+  if(offset < w.size)
+    w.host[offset] = b;
+  else
+    CPUWriteByte(address, b);
+}
+
+static INLINE void BIOS_WriteHalfWord(const biosWindow &w, uint32 address, uint16 value)
+{
+  const uint32 offset = address - w.address;
+
+  if(offset < w.size && w.size - offset >= 2 && !(address & 1))
+    WRITE16LE((uint16 *)(w.host + offset), value);
+  else
+    CPUWriteHalfWord(address, value);
+}
+
+static INLINE void BIOS_WriteWord(const biosWindow &w, uint32 address, uint32 value)
+{
+  const uint32 offset = address - w.address;
+
+  if(offset < w.size && w.size - offset >= 4 && !(address & 3))
+    WRITE32LE((uint32 *)(w.host + offset), value);
+  else
+    CPUWriteMemory(address, value);
+}
+
 void BIOS_ArcTan()
 {
 #ifdef DEV_VERSION
@@ -279,6 +405,9 @@ void BIOS_CpuSet()
     // fill ?
     if((cnt >> 24) & 1) {
         uint32 value = (source>0x0EFFFFFF ? 0x1CAD1CAD : CPUReadMemory(source));
+      uint32 done = BIOS_HostFill(dest, count, value, 4, 1);
+      dest += done << 2;
+      count -= done;
       while(count) {
         CPUWriteMemory(dest, value);
         dest += 4;
@@ -286,6 +415,10 @@ void BIOS_CpuSet()
       }
     } else {
       // copy
+      uint32 done = BIOS_HostCopy(source, dest, count, 4, 1);
+      source += done << 2;
+      dest += done << 2;
+      count -= done;
       while(count) {
         CPUWriteMemory(dest, (source>0x0EFFFFFF ? 0x1CAD1CAD : CPUReadMemory(source)));
         source += 4;
@@ -297,6 +430,9 @@ void BIOS_CpuSet()
     // 16-bit fill?
     if((cnt >> 24) & 1) {
       uint16 value = (source>0x0EFFFFFF ? 0x1CAD : CPUReadHalfWord(source));
+      uint32 done = BIOS_HostFill(dest, count, value, 2, 1);
+      dest += done << 1;
+      count -= done;
       while(count) {
         CPUWriteHalfWord(dest, value);
         dest += 2;
@@ -304,6 +440,10 @@ void BIOS_CpuSet()
       }
     } else {
       // copy
+      uint32 done = BIOS_HostCopy(source, dest, count, 2, 1);
+      source += done << 1;
+      dest += done << 1;
+      count -= done;
       while(count) {
         CPUWriteHalfWord(dest, (source>0x0EFFFFFF ? 0x1CAD : CPUReadHalfWord(source)));
         source += 2;
@@ -339,6 +479,12 @@ void BIOS_CpuFastSet()
   
   // fill?
   if((cnt >> 24) & 1) {
+    if(count > 0) {
+      uint32 value = (source>0x0EFFFFFF ? 0xBAFFFFFB : CPUReadMemory(source));
+      uint32 done = BIOS_HostFill(dest, (count + 7) & ~7, value, 4, 8);
+      dest += done << 2;
+      count -= done;
+    }
     while(count > 0) {
       // BIOS always transfers 32 bytes at a time
       uint32 value = (source>0x0EFFFFFF ? 0xBAFFFFFB : CPUReadMemory(source));
@@ -350,6 +496,12 @@ void BIOS_CpuFastSet()
     }
   } else {
     // copy
+    if(count > 0) {
+      uint32 done = BIOS_HostCopy(source, dest, (count + 7) & ~7, 4, 8);
+      source += done << 2;
+      dest += done << 2;
+      count -= done;
+    }
     while(count > 0) {
       // BIOS always transfers 32 bytes at a time
       for(int i = 0; i < 8; i++) {
@@ -542,20 +694,25 @@ void BIOS_HuffUnComp()
      ((source + ((header >> 8) & 0x1fffff)) & 0xe000000) == 0)
     return;  
   
-  uint8 treeSize = CPUReadByte(source++);
+  int len = header >> 8;
+  biosWindow src, dst;
+
+  // reads past the end of the source window go through the handlers
+  BIOS_ReadWindow(src, source, 0x200 + (len << 1));
+  BIOS_WriteWindow(dst, dest, (len + 3) & ~3, false);
+
+  uint8 treeSize = BIOS_ReadByte(src, source++);
 
   uint32 treeStart = source;
 
   source += ((treeSize+1)<<1)-1; // minus because we already skipped one byte
-  
-  int len = header >> 8;
 
   uint32 mask = 0x80000000;
-  uint32 data = CPUReadMemory(source);
+  uint32 data = BIOS_ReadWord(src, source);
   source += 4;
 
   int pos = 0;
-  uint8 rootNode = CPUReadByte(treeStart);
+  uint8 rootNode = BIOS_ReadByte(src, treeStart);
   uint8 currentNode = rootNode;
   bool writeData = false;
   int byteShift = 0;
@@ -574,12 +731,12 @@ void BIOS_HuffUnComp()
         // right
         if(currentNode & 0x40)
           writeData = true;
-        currentNode = CPUReadByte(treeStart+pos+1);
+        currentNode = BIOS_ReadByte(src, treeStart+pos+1);
       } else {
         // left
         if(currentNode & 0x80)
           writeData = true;
-        currentNode = CPUReadByte(treeStart+pos);
+        currentNode = BIOS_ReadByte(src, treeStart+pos);
       }
       
       if(writeData) {
@@ -594,7 +751,7 @@ void BIOS_HuffUnComp()
         if(byteCount == 4) {
           byteCount = 0;
           byteShift = 0;
-          CPUWriteMemory(dest, writeValue);
+          BIOS_WriteWord(dst, dest, writeValue);
           writeValue = 0;
           dest += 4;
           len -= 4;
@@ -603,7 +760,7 @@ void BIOS_HuffUnComp()
       mask >>= 1;
       if(mask == 0) {
         mask = 0x80000000;
-        data = CPUReadMemory(source);
+        data = BIOS_ReadWord(src, source);
         source += 4;
       }
     }
@@ -621,12 +778,12 @@ void BIOS_HuffUnComp()
         // right
         if(currentNode & 0x40)
           writeData = true;
-        currentNode = CPUReadByte(treeStart+pos+1);
+        currentNode = BIOS_ReadByte(src, treeStart+pos+1);
       } else {
         // left
         if(currentNode & 0x80)
           writeData = true;
-        currentNode = CPUReadByte(treeStart+pos);
+        currentNode = BIOS_ReadByte(src, treeStart+pos);
       }
       
       if(writeData) {
@@ -647,7 +804,7 @@ void BIOS_HuffUnComp()
           if(byteCount == 4) {
             byteCount = 0;
             byteShift = 0;
-            CPUWriteMemory(dest, writeValue);
+            BIOS_WriteWord(dst, dest, writeValue);
             dest += 4;
             writeValue = 0;
             len -= 4;
@@ -660,7 +817,7 @@ void BIOS_HuffUnComp()
       mask >>= 1;
       if(mask == 0) {
         mask = 0x80000000;
-        data = CPUReadMemory(source);
+        data = BIOS_ReadWord(src, source);
         source += 4;
       }
     }    
@@ -693,26 +850,31 @@ void BIOS_LZ77UnCompVram()
   uint32 writeValue = 0;
   
   int len = header >> 8;
+  biosWindow src, dst;
+
+  // a literal costs a byte plus a flag bit, anything else is shorter
+  BIOS_ReadWindow(src, source, len + (len >> 3) + 4);
+  BIOS_WriteWindow(dst, dest, len & ~1, false);
 
   while(len > 0) {
-    uint8 d = CPUReadByte(source++);
+    uint8 d = BIOS_ReadByte(src, source++);
 
     if(d) {
       for(int i = 0; i < 8; i++) {
         if(d & 0x80) {
-          uint16 data = CPUReadByte(source++) << 8;
-          data |= CPUReadByte(source++);
+          uint16 data = BIOS_ReadByte(src, source++) << 8;
+          data |= BIOS_ReadByte(src, source++);
           int length = (data >> 12) + 3;
           int offset = (data & 0x0FFF);
           uint32 windowOffset = dest + byteCount - offset - 1;
 
           for(int j = 0; j < length; j++) {
-            writeValue |= (CPUReadByte(windowOffset++) << byteShift);
+            writeValue |= (BIOS_ReadByte(dst, windowOffset++) << byteShift);
             byteShift += 8;
             byteCount++;
 
             if(byteCount == 2) {
-              CPUWriteHalfWord(dest, writeValue);
+              BIOS_WriteHalfWord(dst, dest, writeValue);
               dest += 2;
               byteCount = 0;
               byteShift = 0;
@@ -723,11 +885,11 @@ void BIOS_LZ77UnCompVram()
               return;
           }
         } else {
-          writeValue |= (CPUReadByte(source++) << byteShift);
+          writeValue |= (BIOS_ReadByte(src, source++) << byteShift);
           byteShift += 8;
           byteCount++;
           if(byteCount == 2) {
-            CPUWriteHalfWord(dest, writeValue);
+            BIOS_WriteHalfWord(dst, dest, writeValue);
             dest += 2;
             byteCount = 0;
             byteShift = 0;
@@ -741,11 +903,11 @@ void BIOS_LZ77UnCompVram()
       }
     } else {
       for(int i = 0; i < 8; i++) {
-        writeValue |= (CPUReadByte(source++) << byteShift);
+        writeValue |= (BIOS_ReadByte(src, source++) << byteShift);
         byteShift += 8;
         byteCount++;
         if(byteCount == 2) {
-          CPUWriteHalfWord(dest, writeValue);
+          BIOS_WriteHalfWord(dst, dest, writeValue);
           dest += 2;      
           byteShift = 0;
           byteCount = 0;
@@ -779,26 +941,51 @@ void BIOS_LZ77UnCompWram()
     return;  
   
   int len = header >> 8;
+  biosWindow src, dst;
+
+  // a literal costs a byte plus a flag bit, anything else is shorter
+  BIOS_ReadWindow(src, source, len + (len >> 3) + 4);
+  BIOS_WriteWindow(dst, dest, len, true);
 
   while(len > 0) {
-    uint8 d = CPUReadByte(source++);
+    uint8 d = BIOS_ReadByte(src, source++);
 
     if(d) {
       for(int i = 0; i < 8; i++) {
         if(d & 0x80) {
-          uint16 data = CPUReadByte(source++) << 8;
-          data |= CPUReadByte(source++);
+          uint16 data = BIOS_ReadByte(src, source++) << 8;
+          data |= BIOS_ReadByte(src, source++);
           int length = (data >> 12) + 3;
           int offset = (data & 0x0FFF);
           uint32 windowOffset = dest - offset - 1;
-          for(int j = 0; j < length; j++) {
-            CPUWriteByte(dest++, CPUReadByte(windowOffset++));
-            len--;
+          int n = length < len ? length : len;
+
+          if(windowOffset - dst.address < dst.size &&
+             dest - dst.address + n <= dst.size) {
+            uint8 *to = dst.host + (dest - dst.address);
+            const uint8 *from = to - offset - 1;
+
+            // short offsets repeat the bytes just written
+            if(offset + 1 >= n)
+              memcpy(to, from, n);
+            else {
+              for(int j = 0; j < n; j++)
+                to[j] = from[j];
+            }
+            dest += n;
+            len -= n;
             if(len == 0)
               return;
+          } else {
+            for(int j = 0; j < length; j++) {
+              BIOS_WriteByte(dst, dest++, BIOS_ReadByte(dst, windowOffset++));
+              len--;
+              if(len == 0)
+                return;
+            }
           }
         } else {
-          CPUWriteByte(dest++, CPUReadByte(source++));
+          BIOS_WriteByte(dst, dest++, BIOS_ReadByte(src, source++));
           len--;
           if(len == 0)
             return;
@@ -807,7 +994,7 @@ void BIOS_LZ77UnCompWram()
       }
     } else {
       for(int i = 0; i < 8; i++) {
-        CPUWriteByte(dest++, CPUReadByte(source++));
+        BIOS_WriteByte(dst, dest++, BIOS_ReadByte(src, source++));
         len--;
         if(len == 0)
           return;
@@ -879,14 +1066,17 @@ void BIOS_RegisterRamReset(uint32 flags)
     }
     if(flags & 0x04) {
       // clear palette RAM
+      CPUHostWritten(0x05000000, 0x400);
       memset(paletteRAM, 0, 0x400);
     }
     if(flags & 0x08) {
       // clear VRAM
+      CPUHostWritten(0x06000000, 0x18000);
       memset(vram, 0, 0x18000);
     }
     if(flags & 0x10) {
       // clean OAM
+      CPUHostWritten(0x07000000, 0x400);
       memset(oam, 0, 0x400);
     }
 
@@ -972,15 +1162,21 @@ void BIOS_RLUnCompVram()
     return;  
   
   int len = header >> 8;
+  biosWindow src, dst;
+
+  // at worst a run header for every literal byte
+  BIOS_ReadWindow(src, source, (len << 1) + 4);
+  BIOS_WriteWindow(dst, dest, len & ~1, false);
+
   int byteCount = 0;
   int byteShift = 0;
   uint32 writeValue = 0;
 
   while(len > 0) {
-    uint8 d = CPUReadByte(source++);
+    uint8 d = BIOS_ReadByte(src, source++);
     int l = d & 0x7F;
     if(d & 0x80) {
-      uint8 data = CPUReadByte(source++);
+      uint8 data = BIOS_ReadByte(src, source++);
       l += 3;
       for(int i = 0;i < l; i++) {
         writeValue |= (data << byteShift);
@@ -988,7 +1184,7 @@ void BIOS_RLUnCompVram()
         byteCount++;
 
         if(byteCount == 2) {
-          CPUWriteHalfWord(dest, writeValue);
+          BIOS_WriteHalfWord(dst, dest, writeValue);
           dest += 2;
           byteCount = 0;
           byteShift = 0;
@@ -1001,11 +1197,11 @@ void BIOS_RLUnCompVram()
     } else {
       l++;
       for(int i = 0; i < l; i++) {
-        writeValue |= (CPUReadByte(source++) << byteShift);
+        writeValue |= (BIOS_ReadByte(src, source++) << byteShift);
         byteShift += 8;
         byteCount++;
         if(byteCount == 2) {
-          CPUWriteHalfWord(dest, writeValue);
+          BIOS_WriteHalfWord(dst, dest, writeValue);
           dest += 2;
           byteCount = 0;
           byteShift = 0;
@@ -1041,23 +1237,38 @@ void BIOS_RLUnCompWram()
     return;  
   
   int len = header >> 8;
+  biosWindow src, dst;
+
+  // at worst a run header for every literal byte
+  BIOS_ReadWindow(src, source, (len << 1) + 4);
+  BIOS_WriteWindow(dst, dest, len, true);
 
   while(len > 0) {
-    uint8 d = CPUReadByte(source++);
+    uint8 d = BIOS_ReadByte(src, source++);
     int l = d & 0x7F;
     if(d & 0x80) {
-      uint8 data = CPUReadByte(source++);
+      uint8 data = BIOS_ReadByte(src, source++);
       l += 3;
-      for(int i = 0;i < l; i++) {
-        CPUWriteByte(dest++, data);
-        len--;
+      int n = l < len ? l : len;
+
+      if(dest - dst.address + n <= dst.size) {
+        memset(dst.host + (dest - dst.address), data, n);
+        dest += n;
+        len -= n;
         if(len == 0)
           return;
+      } else {
+        for(int i = 0;i < l; i++) {
+          BIOS_WriteByte(dst, dest++, data);
+          len--;
+          if(len == 0)
+            return;
+        }
       }
     } else {
       l++;
       for(int i = 0; i < l; i++) {
-        CPUWriteByte(dest++,  CPUReadByte(source++));
+        BIOS_WriteByte(dst, dest++, BIOS_ReadByte(src, source++));
         len--;
         if(len == 0)
           return;
@@ -1079,6 +1290,7 @@ void BIOS_SoftReset()
   armIrqEnable = false;
   C_FLAG = V_FLAG = Z_FLAG = false;
   N_FLAG = 0;
+  flagLazy = 0;
 
   reg[13].I = 0x03007F00;
   reg[14].I = 0x00000000;
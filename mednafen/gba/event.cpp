@@ -0,0 +1,120 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Event queue: a binary min-heap ordered by (time, id).
+
+#include "GBA.h"
+#include "event.h"
+
+int64 eventClock = 0;
+int64 eventTime[EVENT_COUNT];
+
+int eventHeap[EVENT_COUNT];
+int eventHeapPos[EVENT_COUNT];
+int eventHeapSize = 0;
+
+static INLINE bool eventBefore(int a, int b)
+{
+  return eventTime[a] < eventTime[b] || (eventTime[a] == eventTime[b] && a < b);
+}
+
+static INLINE void eventPlace(int pos, int id)
+{
+  eventHeap[pos] = id;
+  eventHeapPos[id] = pos;
+}
+
+static void eventSiftUp(int pos)
+{
+  int id = eventHeap[pos];
+
+  while(pos > 0)
+  {
+    int parent = (pos - 1) >> 1;
+
+    if(!eventBefore(id, eventHeap[parent]))
+      break;
+    eventPlace(pos, eventHeap[parent]);
+    pos = parent;
+  }
+  eventPlace(pos, id);
+}
+
+static void eventSiftDown(int pos)
+{
+  int id = eventHeap[pos];
+
+  for(;;)
+  {
+    int child = pos * 2 + 1;
+
+    if(child >= eventHeapSize)
+      break;
+    if(child + 1 < eventHeapSize && eventBefore(eventHeap[child + 1], eventHeap[child]))
+      child++;
+    if(!eventBefore(eventHeap[child], id))
+      break;
+    eventPlace(pos, eventHeap[child]);
+    pos = child;
+  }
+  eventPlace(pos, id);
+}
+
+void eventReset(void)
+{
+  eventClock = 0;
+  eventHeapSize = 0;
+  for(int i = 0; i < EVENT_COUNT; i++)
+  {
+    eventTime[i] = 0;
+    eventHeapPos[i] = -1;
+  }
+}
+
+void eventSchedule(int id, int32 delay)
+{
+  eventTime[id] = eventClock + delay;
+
+  if(eventHeapPos[id] < 0)
+  {
+    eventPlace(eventHeapSize, id);
+    eventSiftUp(eventHeapSize++);
+  }
+  else
+  {
+    eventSiftUp(eventHeapPos[id]);
+    eventSiftDown(eventHeapPos[id]);
+  }
+}
+
+void eventCancel(int id)
+{
+  int pos = eventHeapPos[id];
+
+  if(pos < 0)
+    return;
+
+  eventHeapPos[id] = -1;
+  if(pos != --eventHeapSize)
+  {
+    int moved = eventHeap[eventHeapSize];
+
+    eventPlace(pos, moved);
+    eventSiftUp(pos);
+    eventSiftDown(eventHeapPos[moved]);
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef VBA_EVENT_H
+#define VBA_EVENT_H
+
+// Timed events serviced by CPULoop().  Event times are absolute;
+// eventClock is the time of the last event boundary and the CPU runs
+// cpuTotalTicks past it.  Events due at the same time are serviced in
+// the order of their ids.
+
+enum
+{
+  EVENT_IRQ,      // end of the IRQ entry delay
+  EVENT_LCD,      // next HDraw/HBlank step
+  EVENT_TIMER0,   // timer overflows; count-up timers are never scheduled
+  EVENT_TIMER1,
+  EVENT_TIMER2,
+  EVENT_TIMER3,
+  EVENT_DMA,      // end of the CPU stall for the DMA transfers run so far
+  EVENT_COUNT
+};
+
+extern int64 eventClock;
+extern int64 eventTime[EVENT_COUNT];
+extern int eventHeap[EVENT_COUNT];
+extern int eventHeapPos[EVENT_COUNT];   // -1 while not scheduled
+extern int eventHeapSize;
+
+void eventReset(void);
+
+// (Re)schedules id delay ticks after eventClock.
+void eventSchedule(int id, int32 delay);
+void eventCancel(int id);
+
+static INLINE bool eventPending(int id)
+{
+  return eventHeapPos[id] >= 0;
+}
+
+static INLINE int32 eventRemaining(int id)
+{
+  return (int32)(eventTime[id] - eventClock);
+}
+
+// Ticks from eventClock to the first scheduled event.
+static INLINE int32 eventTicks(void)
+{
+  return eventHeapSize ? eventRemaining(eventHeap[0]) : 0x7FFFFFFF;
+}
+
+// Removes and returns the first event due at eventClock, -1 if none is.
+static INLINE int eventNextDue(void)
+{
+  if(!eventHeapSize || eventTime[eventHeap[0]] > eventClock)
+    return -1;
+
+  int id = eventHeap[0];
+  eventCancel(id);
+  return id;
+}
+
+#endif // VBA_EVENT_H
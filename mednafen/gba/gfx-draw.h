@@ -236,4 +236,85 @@ static INLINE void gfxAlphaBlend(uint32 *ta, uint32 *tb, int ca, int cb)
   }
 }
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+// Four pixel versions of the helpers the mode renderers composite with,
+// for x a multiple of 4.  The line buffers compare unsigned and SSE2 only
+// has signed compares, so selected colors are kept offset by 0x80000000.
+//
+// Lanes of m from a, the others from b.
+static INLINE __m128i gfxBlend4(__m128i m, __m128i a, __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+// Takes the pixels of line in front of color whose lane of enabled has
+// the layer bit id set.
+static INLINE void gfxSelect4(__m128i &color, __m128i &top, const uint32 *line, int x, int id, __m128i enabled)
+{
+  const __m128i bit = _mm_set1_epi32(id);
+  __m128i v = _mm_xor_si128(_mm_load_si128((const __m128i *)&line[x]), _mm_set1_epi32(0x80000000));
+  __m128i m = _mm_cmplt_epi32(v, _mm_and_si128(color, _mm_set1_epi32(0xFF000000)));
+
+  m = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(enabled, bit), _mm_setzero_si128()), m);
+  color = gfxBlend4(m, v, color);
+  top = gfxBlend4(m, bit, top);
+}
+
+// All ones in the lanes where v & bits is not zero.
+static INLINE __m128i gfxTest4(__m128i v, int bits)
+{
+  __m128i z = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(bits)), _mm_setzero_si128());
+  return _mm_xor_si128(z, _mm_set1_epi32(-1));
+}
+
+// The channels fit in the low halves of the lanes, so 16 bit multiplies do.
+static INLINE __m128i gfxBrightness4(__m128i color, int coeff, bool increase)
+{
+  const __m128i mask = _mm_set1_epi32(0x1F);
+  const __m128i c = _mm_set1_epi32(coeff);
+  __m128i r = _mm_and_si128(color, mask);
+  __m128i g = _mm_and_si128(_mm_srli_epi32(color, 5), mask);
+  __m128i b = _mm_and_si128(_mm_srli_epi32(color, 10), mask);
+
+  if(increase) {
+    r = _mm_add_epi32(r, _mm_srli_epi32(_mm_mullo_epi16(_mm_sub_epi32(mask, r), c), 4));
+    g = _mm_add_epi32(g, _mm_srli_epi32(_mm_mullo_epi16(_mm_sub_epi32(mask, g), c), 4));
+    b = _mm_add_epi32(b, _mm_srli_epi32(_mm_mullo_epi16(_mm_sub_epi32(mask, b), c), 4));
+  } else {
+    r = _mm_sub_epi32(r, _mm_srli_epi32(_mm_mullo_epi16(r, c), 4));
+    g = _mm_sub_epi32(g, _mm_srli_epi32(_mm_mullo_epi16(g, c), 4));
+    b = _mm_sub_epi32(b, _mm_srli_epi32(_mm_mullo_epi16(b, c), 4));
+  }
+  return _mm_or_si128(_mm_and_si128(color, _mm_set1_epi32(0xFFFF0000)),
+                      _mm_or_si128(_mm_slli_epi32(b, 10), _mm_or_si128(_mm_slli_epi32(g, 5), r)));
+}
+
+// One channel of gfxAlphaBlend4(), c0 and c1 in the low five bits.
+static INLINE __m128i gfxAlphaChannel4(__m128i c0, __m128i c1, __m128i ca, __m128i cb)
+{
+  const __m128i mask = _mm_set1_epi32(0x1F);
+
+  c0 = _mm_srli_epi32(_mm_mullo_epi16(_mm_and_si128(c0, mask), ca), 4);
+  c1 = _mm_srli_epi32(_mm_mullo_epi16(_mm_and_si128(c1, mask), cb), 4);
+  return _mm_min_epi16(_mm_add_epi32(c0, c1), mask);
+}
+
+// gfxAlphaBlend() on four pixels; AlphaClampLUT is a clamp to 31.
+static INLINE __m128i gfxAlphaBlend4(__m128i color, __m128i color2, int ca, int cb)
+{
+  const __m128i a = _mm_set1_epi32(ca);
+  const __m128i b = _mm_set1_epi32(cb);
+  __m128i r = gfxAlphaChannel4(color, color2, a, b);
+  __m128i g = gfxAlphaChannel4(_mm_srli_epi32(color, 5), _mm_srli_epi32(color2, 5), a, b);
+  __m128i bl = gfxAlphaChannel4(_mm_srli_epi32(color, 10), _mm_srli_epi32(color2, 10), a, b);
+  __m128i blend = _mm_or_si128(_mm_and_si128(color, _mm_set1_epi32(0xFFFF0000)),
+                               _mm_or_si128(_mm_slli_epi32(bl, 10), _mm_or_si128(_mm_slli_epi32(g, 5), r)));
+
+  // transparent pixels are left alone
+  return gfxBlend4(_mm_srai_epi32(color, 31), color, blend);
+}
+#endif
+
 #endif // VBA_GFX_DRAW_H
@@ -0,0 +1,437 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "GBA.h"
+#include "GBAinline.h"
+#include "Globals.h"
+#include "mp2k.h"
+
+// SoundInfo, found through the pointer at 0x03007FF0
+#define MP2K_INFO_PTR        0x03007FF0
+#define MP2K_IDENT           0x68736D53   // "Smsh"
+#define MP2K_REVERB          0x05
+#define MP2K_MAX_CHANS       0x06
+#define MP2K_MASTER_VOLUME   0x07
+#define MP2K_DIV_FREQ        0x18
+#define MP2K_CHANS           0x50
+#define MP2K_PCM_BUFFER      0x350
+#define MP2K_PCM_BUF_SIZE    0x630        // the left half follows the right one
+#define MP2K_INFO_SIZE       (MP2K_PCM_BUFFER + MP2K_PCM_BUF_SIZE * 2)
+#define MP2K_MAX_CHANNELS    12
+
+// SoundChannel, 0x40 bytes each
+#define CHN_FLAGS            0x00
+#define CHN_TYPE             0x01
+#define CHN_RIGHT_VOLUME     0x02
+#define CHN_LEFT_VOLUME      0x03
+#define CHN_ATTACK           0x04
+#define CHN_DECAY            0x05
+#define CHN_SUSTAIN          0x06
+#define CHN_RELEASE          0x07
+#define CHN_ENV_VOLUME       0x09
+#define CHN_ENV_RIGHT        0x0A
+#define CHN_ENV_LEFT         0x0B
+#define CHN_ECHO_VOLUME      0x0C
+#define CHN_ECHO_LENGTH      0x0D
+#define CHN_COUNT            0x18
+#define CHN_FW               0x1C
+#define CHN_FREQUENCY        0x20
+#define CHN_WAV              0x24
+#define CHN_CURRENT          0x28
+#define CHN_SIZE             0x40
+
+#define CHN_FLAG_ENV         0x03         // 3 attack, 2 decay, 1 sustain
+#define CHN_FLAG_ECHO        0x04
+#define CHN_FLAG_LOOP        0x10
+#define CHN_FLAG_STOP        0x40
+#define CHN_FLAG_START       0x80
+#define CHN_FLAG_ON          0xC7
+
+#define CHN_TYPE_FIX         0x08
+#define CHN_TYPE_UNKNOWN     0x30         // compressed or reversed samples
+
+// WaveData: u16 type, u16 status, u32 freq, u32 loopStart, u32 size, s8 data[]
+#define WAV_LOOP_FLAGS       0x03
+#define WAV_LOOP_START       0x08
+#define WAV_SIZE             0x0C
+#define WAV_DATA             0x10
+
+uint32 mp2kMixerEntry = 0;
+
+// The high quality mode mixes into these, 1/65536 of an output step each,
+// right then left.
+static int32 mp2kAcc[MP2K_PCM_BUF_SIZE * 2];
+
+// Value loaded by the THUMB LDR Rd, [PC, #imm] at pos.
+static uint32 MP2K_Literal(const uint8 *image, uint32 size, uint32 pos)
+{
+  const uint32 address = ((pos + 4) & ~3) + ((READ16LE((uint16 *)(image + pos)) & 0xFF) << 2);
+
+  return address + 4 <= size ? READ32LE((uint32 *)(image + address)) : 0;
+}
+
+void MP2K_Detect(const uint8 *image, uint32 size)
+{
+  mp2kMixerEntry = 0;
+
+  // SoundMain:
+  //   ldr r0, =0x03007FF0; ldr r0, [r0]; ldr r2, =ID_NUMBER; ldr r3, [r0]
+  //   cmp r2, r3; beq 1f; bx lr
+  // ...
+  //   ldr r3, =SoundMainRAM_Buffer + 1; bx r3
+  for(uint32 pos = 0; pos + 14 <= size; pos += 2)
+  {
+    const uint16 *insn = (const uint16 *)(image + pos);
+
+    if((READ16LE(insn) & 0xFF00) != 0x4800 || READ16LE(insn + 1) != 0x6800 ||
+       (READ16LE(insn + 2) & 0xFF00) != 0x4A00 || READ16LE(insn + 3) != 0x6803 ||
+       READ16LE(insn + 4) != 0x429A || (READ16LE(insn + 5) & 0xFF00) != 0xD000 ||
+       READ16LE(insn + 6) != 0x4770)
+      continue;
+
+    if(MP2K_Literal(image, size, pos) != MP2K_INFO_PTR ||
+       MP2K_Literal(image, size, pos + 4) != MP2K_IDENT)
+      continue;
+
+    for(uint32 jump = pos + 14; jump + 4 <= size && jump < pos + 0x100; jump += 2)
+    {
+      const uint16 *j = (const uint16 *)(image + jump);
+
+      if((READ16LE(j) & 0xFF00) == 0x4B00 && READ16LE(j + 1) == 0x4718)
+      {
+        const uint32 entry = MP2K_Literal(image, size, jump);
+
+        if((entry >> 24) == 0x03 && (entry & 1))
+        {
+          mp2kMixerEntry = entry;
+          MDFN_printf(_("MP2K mixer at 0x%08x\n"), entry & ~1);
+          return;
+        }
+        break;
+      }
+    }
+  }
+}
+
+static void MP2K_Reverb(uint8 *info, uint8 *pcm, uint32 samples, uint32 counter)
+{
+  const int reverb = info[MP2K_REVERB];
+  const uint8 *prev = (counter == 2) ? info + MP2K_PCM_BUFFER : pcm + samples;
+
+  for(uint32 i = 0; i < samples; i++)
+  {
+    int v = (int8)pcm[i + MP2K_PCM_BUF_SIZE] + (int8)pcm[i] +
+            (int8)prev[i + MP2K_PCM_BUF_SIZE] + (int8)prev[i];
+
+    v = (v * reverb) >> 9;
+    if(v & 0x80)
+      v++;
+    pcm[i] = pcm[i + MP2K_PCM_BUF_SIZE] = v;
+  }
+}
+
+// Sample at pos plus the fraction fw (23 bits) of the way to the next one,
+// times 256, interpolated through the samples on either side (Catmull-Rom).
+// Reads stay within data[0] to data[size], which MP2K_Mix() checked.
+static INLINE int32 MP2K_Cubic(const uint8 *data, uint32 pos, uint32 size, uint32 fw)
+{
+  const int64 p0 = (int8)data[pos ? pos - 1 : 0] * 256;
+  const int64 p1 = (int8)data[pos] * 256;
+  const int64 p2 = (int8)data[pos + 1] * 256;
+  const int64 p3 = (int8)data[pos + 2 <= size ? pos + 2 : size] * 256;
+  const int64 t = fw >> 8;   // 15 bits
+
+  int64 v = 3 * (p1 - p2) + p3 - p0;
+  v = ((v * t) >> 15) + 2 * p0 - 5 * p1 + 4 * p2 - p3;
+  v = ((v * t) >> 15) + p2 - p0;
+  v = ((v * t) >> 15) + 2 * p1;
+  return (int32)(v >> 1);
+}
+
+// Envelope step and mixing of one DirectSound channel, as SoundMainRAM()
+// does them.  The sample data was checked to be plain memory.  HQ mixes
+// into mp2kAcc instead of pcm, interpolating variable rate samples through
+// four points instead of two.
+template<bool HQ>
+static void MP2K_MixChannel(const uint8 *info, uint8 *ch, const uint8 *wave, uint8 *pcm, uint32 samples)
+{
+  const uint32 wav = READ32LE((uint32 *)(ch + CHN_WAV));
+  const uint32 size = READ32LE((uint32 *)(wave + WAV_SIZE));
+  uint8 flags = ch[CHN_FLAGS];
+  uint32 env = ch[CHN_ENV_VOLUME];
+  bool echo = false;
+
+  if(flags & CHN_FLAG_START)
+  {
+    if(flags & CHN_FLAG_STOP)
+    {
+      ch[CHN_FLAGS] = 0;
+      return;
+    }
+
+    // the count holds the start offset until the note starts
+    const uint32 start = READ32LE((uint32 *)(ch + CHN_COUNT));
+
+    WRITE32LE((uint32 *)(ch + CHN_CURRENT), wav + WAV_DATA + start);
+    WRITE32LE((uint32 *)(ch + CHN_COUNT), size - start);
+    WRITE32LE((uint32 *)(ch + CHN_FW), 0);
+    flags = 3;
+    if(wave[WAV_LOOP_FLAGS] & 0xC0)
+      flags |= CHN_FLAG_LOOP;
+    env = 0;
+  }
+
+  if(flags & CHN_FLAG_ECHO)
+  {
+    if(ch[CHN_ECHO_LENGTH]-- <= 1)
+    {
+      ch[CHN_FLAGS] = 0;
+      return;
+    }
+  }
+  else if(flags & CHN_FLAG_STOP)
+  {
+    env = (env * ch[CHN_RELEASE]) >> 8;
+    echo = env <= ch[CHN_ECHO_VOLUME];
+  }
+  else if((flags & CHN_FLAG_ENV) == 2)
+  {
+    env = (env * ch[CHN_DECAY]) >> 8;
+    if(env <= ch[CHN_SUSTAIN])
+    {
+      env = ch[CHN_SUSTAIN];
+      if(env)
+        flags--;
+      else
+        echo = true;
+    }
+  }
+  else if((flags & CHN_FLAG_ENV) == 3)
+  {
+    env += ch[CHN_ATTACK];
+    if(env >= 0xFF)
+    {
+      env = 0xFF;
+      flags--;
+    }
+  }
+
+  if(echo)
+  {
+    env = ch[CHN_ECHO_VOLUME];
+    if(!env)
+    {
+      ch[CHN_FLAGS] = 0;
+      return;
+    }
+    flags |= CHN_FLAG_ECHO;
+  }
+
+  const uint32 volume = ((info[MP2K_MASTER_VOLUME] + 1) * env) >> 4;
+  const int right = ch[CHN_ENV_RIGHT] = (ch[CHN_RIGHT_VOLUME] * volume) >> 8;
+  const int left = ch[CHN_ENV_LEFT] = (ch[CHN_LEFT_VOLUME] * volume) >> 8;
+
+  ch[CHN_ENV_VOLUME] = env;
+
+  const uint32 loopStart = READ32LE((uint32 *)(wave + WAV_LOOP_START));
+  const bool loop = (flags & CHN_FLAG_LOOP) && loopStart < size;
+  const uint8 *data = wave + WAV_DATA;
+  uint32 pos = READ32LE((uint32 *)(ch + CHN_CURRENT)) - (wav + WAV_DATA);
+  uint32 count = READ32LE((uint32 *)(ch + CHN_COUNT));
+  uint32 fw = READ32LE((uint32 *)(ch + CHN_FW));
+  const uint32 step = READ32LE((uint32 *)(ch + CHN_FREQUENCY)) * READ32LE((uint32 *)(info + MP2K_DIV_FREQ));
+  const bool fixed = ch[CHN_TYPE] & CHN_TYPE_FIX;
+
+  for(uint32 i = 0; i < samples; i++)
+  {
+    if(HQ)
+    {
+      const int32 sample = fixed ? (int8)data[pos] * 256 : MP2K_Cubic(data, pos, size, fw);
+
+      mp2kAcc[i] += sample * right;
+      mp2kAcc[i + MP2K_PCM_BUF_SIZE] += sample * left;
+    }
+    else
+    {
+      int sample = (int8)data[pos];
+
+      if(!fixed)
+        sample += ((int32)fw * ((int8)data[pos + 1] - sample)) >> 23;
+
+      pcm[i] += (sample * right) >> 8;
+      pcm[i + MP2K_PCM_BUF_SIZE] += (sample * left) >> 8;
+    }
+
+    uint32 advance = 1;
+
+    if(!fixed)
+    {
+      fw += step;
+      advance = fw >> 23;
+      fw &= 0x7FFFFF;
+    }
+
+    if(advance < count)
+    {
+      count -= advance;
+      pos += advance;
+      continue;
+    }
+
+    if(!loop)
+    {
+      flags = 0;
+      count = 0;
+      break;
+    }
+
+    // wrap around the loop, however far the sample stepped past its end
+    advance -= count;
+    advance %= size - loopStart;
+    pos = loopStart + advance;
+    count = size - pos;
+  }
+
+  ch[CHN_FLAGS] = flags;
+  WRITE32LE((uint32 *)(ch + CHN_COUNT), count);
+  WRITE32LE((uint32 *)(ch + CHN_FW), fw);
+  WRITE32LE((uint32 *)(ch + CHN_CURRENT), wav + WAV_DATA + pos);
+}
+
+bool MP2K_Mix(void)
+{
+  uint8 *stack;
+  uint8 *info;
+
+  if(!setting_gba_mp2k_hle)
+    return false;
+
+  // SoundMain() left its frame on the stack: 0x18 bytes of locals, the
+  // SoundInfo pointer, r8-r11, then r4-r7 and lr
+  const uint32 sp = reg[13].I;
+
+  if(CPUHostSpan(memoryWritePages, sp, 0x40, &stack) < 0x40)
+    return false;
+
+  const uint32 infoAddress = READ32LE((uint32 *)(stack + 0x18));
+
+  if(CPUHostSpan(memoryWritePages, infoAddress, MP2K_INFO_SIZE, &info) < MP2K_INFO_SIZE)
+    return false;
+
+  const uint32 samples = reg[8].I;
+  const uint32 offset = reg[5].I - (infoAddress + MP2K_PCM_BUFFER);
+  const uint32 chans = info[MP2K_MAX_CHANS] < MP2K_MAX_CHANNELS ? info[MP2K_MAX_CHANS] : MP2K_MAX_CHANNELS;
+  const uint8 *waves[MP2K_MAX_CHANNELS];
+
+  if(offset > MP2K_PCM_BUF_SIZE || samples > MP2K_PCM_BUF_SIZE - offset)
+    return false;
+
+  // leave it all to the guest unless every sample is plain memory
+  for(uint32 n = 0; n < chans; n++)
+  {
+    const uint8 *ch = info + MP2K_CHANS + n * CHN_SIZE;
+    const uint32 wav = READ32LE((uint32 *)(ch + CHN_WAV));
+    uint8 *wave;
+
+    waves[n] = NULL;
+    if(!(ch[CHN_FLAGS] & CHN_FLAG_ON))
+      continue;
+    if(ch[CHN_TYPE] & CHN_TYPE_UNKNOWN)
+      return false;
+    if(CPUHostSpan(memoryReadPages, wav, WAV_DATA, &wave) < WAV_DATA)
+      return false;
+
+    const uint32 size = READ32LE((uint32 *)(wave + WAV_SIZE));
+
+    // one byte of slack for the interpolation at the end
+    if(size >= 0x1000000 || CPUHostSpan(memoryReadPages, wav, WAV_DATA + size + 1, &wave) < WAV_DATA + size + 1)
+      return false;
+    if(ch[CHN_FLAGS] & CHN_FLAG_START)
+    {
+      if(READ32LE((uint32 *)(ch + CHN_COUNT)) > size)
+        return false;
+    }
+    else if(READ32LE((uint32 *)(ch + CHN_CURRENT)) - (wav + WAV_DATA) >= size)
+      return false;
+    waves[n] = wave;
+  }
+
+  uint8 *pcm = info + MP2K_PCM_BUFFER + offset;
+
+  if(info[MP2K_REVERB])
+    MP2K_Reverb(info, pcm, samples, reg[4].I);
+  else
+  {
+    memset(pcm, 0, samples);
+    memset(pcm + MP2K_PCM_BUF_SIZE, 0, samples);
+  }
+
+  if(setting_gba_mp2k_hle == 2)
+  {
+    // sum at full precision, then round and clip once instead of letting
+    // each channel's truncated share wrap the byte around
+    for(uint32 i = 0; i < samples; i++)
+    {
+      mp2kAcc[i] = (int8)pcm[i] * 65536;
+      mp2kAcc[i + MP2K_PCM_BUF_SIZE] = (int8)pcm[i + MP2K_PCM_BUF_SIZE] * 65536;
+    }
+
+    for(uint32 n = 0; n < chans; n++)
+    {
+      if(waves[n])
+        MP2K_MixChannel<true>(info, info + MP2K_CHANS + n * CHN_SIZE, waves[n], pcm, samples);
+    }
+
+    for(uint32 i = 0; i < samples; i++)
+    {
+      for(uint32 side = 0; side < MP2K_PCM_BUF_SIZE * 2; side += MP2K_PCM_BUF_SIZE)
+      {
+        int32 v = (mp2kAcc[i + side] + 0x8000) >> 16;
+
+        if(v > 127)
+          v = 127;
+        else if(v < -128)
+          v = -128;
+        pcm[i + side] = v;
+      }
+    }
+  }
+  else
+  {
+    for(uint32 n = 0; n < chans; n++)
+    {
+      if(waves[n])
+        MP2K_MixChannel<false>(info, info + MP2K_CHANS + n * CHN_SIZE, waves[n], pcm, samples);
+    }
+  }
+
+  // the epilogue of SoundMainRAM(): release the SoundInfo lock and return
+  WRITE32LE((uint32 *)info, MP2K_IDENT);
+  CPUHostWritten(infoAddress, MP2K_INFO_SIZE);
+
+  for(int i = 0; i < 4; i++)
+  {
+    reg[8 + i].I = READ32LE((uint32 *)(stack + 0x1C + i * 4));
+    reg[4 + i].I = READ32LE((uint32 *)(stack + 0x2C + i * 4));
+  }
+  reg[0].I = reg[8].I;
+  reg[1].I = reg[9].I;
+  reg[2].I = reg[10].I;
+  reg[3].I = READ32LE((uint32 *)(stack + 0x3C));
+  reg[13].I = sp + 0x40;
+  return true;
+}
@@ -0,0 +1,21 @@
+#ifndef VBA_MP2K_H
+#define VBA_MP2K_H
+
+// High-level emulation of the mixer of the MusicPlayer2000 (m4a, "Sappy")
+// sound driver.  SoundMain() jumps into its mixer, SoundMainRAM(), with a
+// BX to a copy in IWRAM; that jump lands in MP2K_Mix() instead, which mixes
+// the DirectSound channels into the driver's PCM buffer natively.
+
+// THUMB address of SoundMainRAM() found in the ROM, 0 if none was.
+extern uint32 mp2kMixerEntry;
+
+void MP2K_Detect(const uint8 *image, uint32 size);
+
+// Called on a BX to mp2kMixerEntry.  Returns false when the guest mixer has
+// to run after all, otherwise does its work and its epilogue, leaving the
+// return address in r3 like the guest code does.  With setting_gba_mp2k_hle
+// at 2 the channels are mixed at full precision, with four point
+// interpolation and clipping, for output cleaner than the driver's own.
+bool MP2K_Mix(void);
+
+#endif
@@ -0,0 +1,108 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Host tool that times the codeTicksAccess*() and dataTicksAccess*() helpers
+// on the access sequences the interpreters charge per instruction: a THUMB
+// or ARM fetch, alone or with an LDR to another region.  It runs with the
+// reset WAITCNT and with the one most games set (3/1 ROM waits, prefetch
+// on) and prints the best ns per instruction over 16 passes, plus a tick
+// total that has to match between builds.  Built by "make WAITSTATE_BENCH=1"
+// and linked against the core objects.
+
+#include "GBA.h"
+#include "GBAinline.h"
+#include "Globals.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_FETCH16(pc) \
+  busPrefetch = false; \
+  if(busPrefetchCount > 16) \
+    busPrefetchCount = 8; \
+  ticks += codeTicksAccessSeq16(pc) + 1;
+#define BENCH_FETCH32(pc) \
+  busPrefetch = false; \
+  if(busPrefetchCount > 16) \
+    busPrefetchCount = 8; \
+  ticks += codeTicksAccessSeq32(pc) + 1;
+#define BENCH_LOAD16(pc, address) \
+  busPrefetch = busPrefetchEnable; \
+  ticks += 3 + dataTicksAccesint32(address) + codeTicksAccesint16(pc);
+#define BENCH_LOAD32(pc, address) \
+  busPrefetch = busPrefetchEnable; \
+  ticks += 3 + dataTicksAccesint32(address) + codeTicksAccesint32(pc);
+
+// Best of several passes, as other load on the host only adds time.
+#define BENCH(name, code) \
+  { \
+    uint32 ticks = 0; \
+    double best = 0; \
+    const uint32 romBase = benchRom; \
+    const uint32 ewramBase = benchEwram; \
+    const uint32 iwramBase = benchIwram; \
+    for(int pass = 0; pass < 16; pass++) \
+    { \
+      ticks = 0; \
+      busPrefetch = false; \
+      busPrefetchCount = 0; \
+      clock_t start = clock(); \
+      for(uint32 i = 0; i < iterations; i++) \
+      { \
+        uint32 rom = romBase + ((i & 0xFFF) << 2); \
+        uint32 ewram = ewramBase + ((i & 0xFFF) << 2); \
+        uint32 iwram = iwramBase + ((i & 0xFFF) << 2); \
+        code \
+      } \
+      double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / iterations; \
+      if(!pass || ns < best) \
+        best = ns; \
+    } \
+    printf("WAITCNT %04x  %-22s %6.2f ns/insn  %u ticks\n", waitcnt, name, best, ticks); \
+  }
+
+// volatile, so that the compiler cannot fold the region checks away
+static volatile uint32 benchRom = 0x08000000;
+static volatile uint32 benchEwram = 0x02000000;
+static volatile uint32 benchIwram = 0x03000000;
+
+static uint8 benchIoMem[0x400];
+
+int main(void)
+{
+  static const uint16 waitcnts[2] = { 0x0000, 0x4317 };
+  const uint32 iterations = 1 << 22;
+
+  // CPUUpdateRegister() keeps WAITCNT in the I/O registers
+  ioMem = benchIoMem;
+
+  for(int w = 0; w < 2; w++)
+  {
+    const uint16 waitcnt = waitcnts[w];
+
+    CPUUpdateRegister(0x204, waitcnt);
+
+    BENCH("THUMB ROM", BENCH_FETCH16(rom))
+    BENCH("THUMB ROM, LDR EWRAM", BENCH_FETCH16(rom) BENCH_LOAD16(rom, ewram))
+    BENCH("THUMB IWRAM, LDR ROM", BENCH_FETCH16(iwram) BENCH_LOAD16(iwram, rom))
+    BENCH("ARM ROM", BENCH_FETCH32(rom))
+    BENCH("ARM ROM, LDR IWRAM", BENCH_FETCH32(rom) BENCH_LOAD32(rom, iwram))
+    BENCH("ARM IWRAM, LDR ROM", BENCH_FETCH32(iwram) BENCH_LOAD32(iwram, rom))
+  }
+
+  return 0;
+}
@@ -214,6 +214,10 @@ typedef struct
 	// Skip rendering this frame if true.  Set by the driver code.
 	int skip;
 
+	// Set by the emulation code when the framebuffer holds the same image as after the previous frame,
+	// which the driver may then present again without uploading it.
+	bool FrameUnchanged;
+
 	//
 	// If sound is disabled, the driver code must set SoundRate to false, SoundBuf to NULL, SoundBufMaxSize to 0.
 
@@ -22,6 +22,9 @@
 #include "settings.h"
 
 uint32_t setting_gba_hle = 1;
+uint32_t setting_gba_idle_loop = 1;
+uint32_t setting_gba_mp2k_hle = 0;
+uint32_t setting_gba_threaded_render = 0;
 
 uint64 MDFN_GetSettingUI(const char *name)
 {
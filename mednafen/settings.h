@@ -4,6 +4,9 @@
 #include <string>
 
 extern uint32_t setting_gba_hle;
+extern uint32_t setting_gba_idle_loop;
+extern uint32_t setting_gba_mp2k_hle;
+extern uint32_t setting_gba_threaded_render;
 
 bool MDFN_LoadSettings(const char *path, const char *section = NULL, bool override = false);
 bool MDFN_MergeSettings(const void*);